@@ -0,0 +1,257 @@
+// Video Texture Shader
+// Same layout as Renderer2D_Quad.glsl, plus a per-vertex pixel format so planar YUV videos
+// can be converted to RGB here instead of on the CPU.
+
+#type vertex
+#version 450 core
+
+layout(location = 0) in vec3 a_Position;
+layout(location = 1) in vec4 a_Color;
+layout(location = 2) in vec2 a_TexCoord;
+layout(location = 3) in vec2 a_TilingFactor;
+layout(location = 4) in float a_TexIndex;
+layout(location = 5) in int a_PixelFormat;
+layout(location = 6) in int a_EntityID;
+
+layout(std140, binding = 0) uniform Camera
+{
+	mat4 u_ViewProjection;
+};
+
+struct VertexOutput
+{
+	vec4 Color;
+	vec2 TexCoord;
+	vec2 TilingFactor;
+};
+
+layout (location = 0) out VertexOutput Output;
+layout (location = 3) out flat float v_TexIndex;
+layout (location = 4) out flat int v_PixelFormat;
+layout (location = 5) out flat int v_EntityID;
+
+void main()
+{
+	Output.Color = a_Color;
+	Output.TexCoord = a_TexCoord;
+	Output.TilingFactor = a_TilingFactor;
+	v_TexIndex = a_TexIndex;
+	v_PixelFormat = a_PixelFormat;
+	v_EntityID = a_EntityID;
+
+	gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
+}
+
+#type fragment
+#version 450 core
+
+layout(location = 0) out vec4 o_Color;
+layout(location = 1) out int o_EntityID;
+
+struct VertexOutput
+{
+	vec4 Color;
+	vec2 TexCoord;
+	vec2 TilingFactor;
+};
+
+layout (location = 0) in VertexOutput Input;
+layout (location = 3) in flat float v_TexIndex;
+layout (location = 4) in flat int v_PixelFormat;
+layout (location = 5) in flat int v_EntityID;
+
+layout (binding = 0) uniform sampler2D u_Textures[32];
+
+// Fixed point (8.8) YUV -> RGB coefficients, indexed by v_PixelFormat - 1:
+// YOffset, YScale, RV, GU, GV, BU
+// Keep in sync with s_YUVToRGBCoefficients in VideoColorConversion.cpp!
+const int c_YUVCoefficients[24] = int[24](
+	16, 298, 409, -100, -208, 516,  // BT.601, limited range
+	 0, 256, 359,  -88, -183, 454,  // BT.601, full range
+	16, 298, 459,  -55, -136, 541,  // BT.709, limited range
+	 0, 256, 403,  -48, -120, 475   // BT.709, full range
+);
+
+vec4 SampleRGBA(int index, vec2 uv)
+{
+	switch (index)
+	{
+		case  0: return texture(u_Textures[ 0], uv);
+		case  1: return texture(u_Textures[ 1], uv);
+		case  2: return texture(u_Textures[ 2], uv);
+		case  3: return texture(u_Textures[ 3], uv);
+		case  4: return texture(u_Textures[ 4], uv);
+		case  5: return texture(u_Textures[ 5], uv);
+		case  6: return texture(u_Textures[ 6], uv);
+		case  7: return texture(u_Textures[ 7], uv);
+		case  8: return texture(u_Textures[ 8], uv);
+		case  9: return texture(u_Textures[ 9], uv);
+		case 10: return texture(u_Textures[10], uv);
+		case 11: return texture(u_Textures[11], uv);
+		case 12: return texture(u_Textures[12], uv);
+		case 13: return texture(u_Textures[13], uv);
+		case 14: return texture(u_Textures[14], uv);
+		case 15: return texture(u_Textures[15], uv);
+		case 16: return texture(u_Textures[16], uv);
+		case 17: return texture(u_Textures[17], uv);
+		case 18: return texture(u_Textures[18], uv);
+		case 19: return texture(u_Textures[19], uv);
+		case 20: return texture(u_Textures[20], uv);
+		case 21: return texture(u_Textures[21], uv);
+		case 22: return texture(u_Textures[22], uv);
+		case 23: return texture(u_Textures[23], uv);
+		case 24: return texture(u_Textures[24], uv);
+		case 25: return texture(u_Textures[25], uv);
+		case 26: return texture(u_Textures[26], uv);
+		case 27: return texture(u_Textures[27], uv);
+		case 28: return texture(u_Textures[28], uv);
+		case 29: return texture(u_Textures[29], uv);
+		case 30: return texture(u_Textures[30], uv);
+		case 31: return texture(u_Textures[31], uv);
+	}
+
+	return vec4(1.0);
+}
+
+ivec2 GetLumaSize(int index)
+{
+	switch (index)
+	{
+		case  0: return textureSize(u_Textures[ 0], 0);
+		case  1: return textureSize(u_Textures[ 1], 0);
+		case  2: return textureSize(u_Textures[ 2], 0);
+		case  3: return textureSize(u_Textures[ 3], 0);
+		case  4: return textureSize(u_Textures[ 4], 0);
+		case  5: return textureSize(u_Textures[ 5], 0);
+		case  6: return textureSize(u_Textures[ 6], 0);
+		case  7: return textureSize(u_Textures[ 7], 0);
+		case  8: return textureSize(u_Textures[ 8], 0);
+		case  9: return textureSize(u_Textures[ 9], 0);
+		case 10: return textureSize(u_Textures[10], 0);
+		case 11: return textureSize(u_Textures[11], 0);
+		case 12: return textureSize(u_Textures[12], 0);
+		case 13: return textureSize(u_Textures[13], 0);
+		case 14: return textureSize(u_Textures[14], 0);
+		case 15: return textureSize(u_Textures[15], 0);
+		case 16: return textureSize(u_Textures[16], 0);
+		case 17: return textureSize(u_Textures[17], 0);
+		case 18: return textureSize(u_Textures[18], 0);
+		case 19: return textureSize(u_Textures[19], 0);
+		case 20: return textureSize(u_Textures[20], 0);
+		case 21: return textureSize(u_Textures[21], 0);
+		case 22: return textureSize(u_Textures[22], 0);
+		case 23: return textureSize(u_Textures[23], 0);
+		case 24: return textureSize(u_Textures[24], 0);
+		case 25: return textureSize(u_Textures[25], 0);
+		case 26: return textureSize(u_Textures[26], 0);
+		case 27: return textureSize(u_Textures[27], 0);
+		case 28: return textureSize(u_Textures[28], 0);
+		case 29: return textureSize(u_Textures[29], 0);
+	}
+
+	return ivec2(1);
+}
+
+// A YUV video occupies three consecutive slots: Y, U and V
+ivec3 FetchYUV(int index, ivec2 luma, ivec2 chroma)
+{
+	switch (index)
+	{
+		case  0: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 0], luma, 0).r, texelFetch(u_Textures[ 1], chroma, 0).r, texelFetch(u_Textures[ 2], chroma, 0).r)));
+		case  1: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 1], luma, 0).r, texelFetch(u_Textures[ 2], chroma, 0).r, texelFetch(u_Textures[ 3], chroma, 0).r)));
+		case  2: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 2], luma, 0).r, texelFetch(u_Textures[ 3], chroma, 0).r, texelFetch(u_Textures[ 4], chroma, 0).r)));
+		case  3: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 3], luma, 0).r, texelFetch(u_Textures[ 4], chroma, 0).r, texelFetch(u_Textures[ 5], chroma, 0).r)));
+		case  4: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 4], luma, 0).r, texelFetch(u_Textures[ 5], chroma, 0).r, texelFetch(u_Textures[ 6], chroma, 0).r)));
+		case  5: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 5], luma, 0).r, texelFetch(u_Textures[ 6], chroma, 0).r, texelFetch(u_Textures[ 7], chroma, 0).r)));
+		case  6: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 6], luma, 0).r, texelFetch(u_Textures[ 7], chroma, 0).r, texelFetch(u_Textures[ 8], chroma, 0).r)));
+		case  7: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 7], luma, 0).r, texelFetch(u_Textures[ 8], chroma, 0).r, texelFetch(u_Textures[ 9], chroma, 0).r)));
+		case  8: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 8], luma, 0).r, texelFetch(u_Textures[ 9], chroma, 0).r, texelFetch(u_Textures[10], chroma, 0).r)));
+		case  9: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[ 9], luma, 0).r, texelFetch(u_Textures[10], chroma, 0).r, texelFetch(u_Textures[11], chroma, 0).r)));
+		case 10: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[10], luma, 0).r, texelFetch(u_Textures[11], chroma, 0).r, texelFetch(u_Textures[12], chroma, 0).r)));
+		case 11: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[11], luma, 0).r, texelFetch(u_Textures[12], chroma, 0).r, texelFetch(u_Textures[13], chroma, 0).r)));
+		case 12: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[12], luma, 0).r, texelFetch(u_Textures[13], chroma, 0).r, texelFetch(u_Textures[14], chroma, 0).r)));
+		case 13: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[13], luma, 0).r, texelFetch(u_Textures[14], chroma, 0).r, texelFetch(u_Textures[15], chroma, 0).r)));
+		case 14: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[14], luma, 0).r, texelFetch(u_Textures[15], chroma, 0).r, texelFetch(u_Textures[16], chroma, 0).r)));
+		case 15: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[15], luma, 0).r, texelFetch(u_Textures[16], chroma, 0).r, texelFetch(u_Textures[17], chroma, 0).r)));
+		case 16: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[16], luma, 0).r, texelFetch(u_Textures[17], chroma, 0).r, texelFetch(u_Textures[18], chroma, 0).r)));
+		case 17: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[17], luma, 0).r, texelFetch(u_Textures[18], chroma, 0).r, texelFetch(u_Textures[19], chroma, 0).r)));
+		case 18: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[18], luma, 0).r, texelFetch(u_Textures[19], chroma, 0).r, texelFetch(u_Textures[20], chroma, 0).r)));
+		case 19: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[19], luma, 0).r, texelFetch(u_Textures[20], chroma, 0).r, texelFetch(u_Textures[21], chroma, 0).r)));
+		case 20: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[20], luma, 0).r, texelFetch(u_Textures[21], chroma, 0).r, texelFetch(u_Textures[22], chroma, 0).r)));
+		case 21: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[21], luma, 0).r, texelFetch(u_Textures[22], chroma, 0).r, texelFetch(u_Textures[23], chroma, 0).r)));
+		case 22: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[22], luma, 0).r, texelFetch(u_Textures[23], chroma, 0).r, texelFetch(u_Textures[24], chroma, 0).r)));
+		case 23: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[23], luma, 0).r, texelFetch(u_Textures[24], chroma, 0).r, texelFetch(u_Textures[25], chroma, 0).r)));
+		case 24: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[24], luma, 0).r, texelFetch(u_Textures[25], chroma, 0).r, texelFetch(u_Textures[26], chroma, 0).r)));
+		case 25: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[25], luma, 0).r, texelFetch(u_Textures[26], chroma, 0).r, texelFetch(u_Textures[27], chroma, 0).r)));
+		case 26: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[26], luma, 0).r, texelFetch(u_Textures[27], chroma, 0).r, texelFetch(u_Textures[28], chroma, 0).r)));
+		case 27: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[27], luma, 0).r, texelFetch(u_Textures[28], chroma, 0).r, texelFetch(u_Textures[29], chroma, 0).r)));
+		case 28: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[28], luma, 0).r, texelFetch(u_Textures[29], chroma, 0).r, texelFetch(u_Textures[30], chroma, 0).r)));
+		case 29: return ivec3(round(255.0 * vec3(texelFetch(u_Textures[29], luma, 0).r, texelFetch(u_Textures[30], chroma, 0).r, texelFetch(u_Textures[31], chroma, 0).r)));
+	}
+
+	return ivec3(0, 128, 128);
+}
+
+// Integer math identical to ConvertYUV420ToRGBA(), so a 1:1 draw matches it bit for bit
+vec3 ConvertTexel(int index, int format, ivec2 texel, ivec2 size)
+{
+	texel = ivec2(mod(vec2(texel), vec2(size)));
+	ivec3 yuv = FetchYUV(index, texel, texel >> 1);
+
+	int k = (format - 1) * 6;
+	int c = (yuv.x - c_YUVCoefficients[k + 0]) * c_YUVCoefficients[k + 1];
+	int d = yuv.y - 128;
+	int e = yuv.z - 128;
+
+	ivec3 rgb = ivec3(
+		(c + c_YUVCoefficients[k + 2] * e + 128) >> 8,
+		(c + c_YUVCoefficients[k + 3] * d + c_YUVCoefficients[k + 4] * e + 128) >> 8,
+		(c + c_YUVCoefficients[k + 5] * d + 128) >> 8);
+
+	return vec3(clamp(rgb, 0, 255));
+}
+
+// v_PixelFormat 1-4 are filtered linearly and 5-8 are the same formats with nearest filtering,
+// standing in for the magnification filter an RGBA video texture gets from UseLinear
+vec4 SampleYUV(int index, int pixelFormat, vec2 uv)
+{
+	int format = (pixelFormat - 1) % 4 + 1;
+	ivec2 size = GetLumaSize(index);
+
+	if (pixelFormat > 4)
+	{
+		ivec2 texel = ivec2(floor(fract(uv) * vec2(size)));
+		return vec4(ConvertTexel(index, format, texel, size) / 255.0, 1.0);
+	}
+
+	// Filter the converted texels ourselves, so the result stays exact at texel centres
+	vec2 position = fract(uv) * vec2(size) - 0.5;
+	ivec2 base = ivec2(floor(position));
+	vec2 weight = position - vec2(base);
+
+	vec3 c00 = ConvertTexel(index, format, base, size);
+	vec3 c10 = ConvertTexel(index, format, base + ivec2(1, 0), size);
+	vec3 c01 = ConvertTexel(index, format, base + ivec2(0, 1), size);
+	vec3 c11 = ConvertTexel(index, format, base + ivec2(1, 1), size);
+
+	vec3 rgb = mix(mix(c00, c10, weight.x), mix(c01, c11, weight.x), weight.y);
+	return vec4(rgb / 255.0, 1.0);
+}
+
+void main()
+{
+	vec4 texColor = Input.Color;
+	vec2 uv = Input.TexCoord * Input.TilingFactor;
+	int index = int(v_TexIndex);
+
+	if (v_PixelFormat == 0)
+		texColor *= SampleRGBA(index, uv);
+	else
+		texColor *= SampleYUV(index, v_PixelFormat, uv);
+
+	if (texColor.a == 0.0)
+		discard;
+
+	o_Color = texColor;
+	o_EntityID = v_EntityID;
+}
@@ -1,7 +1,9 @@
 #include "nzpch.h"
 #include "VideoRenderer.h"
 
+#include "Nutcrackz/Video/AudioMixer.h"
 #include "Nutcrackz/Video/VideoTexture.h"
+#include "Nutcrackz/Video/VideoWorkerPool.h"
 
 #include "VertexArray.h"
 #include "Shader.h"
@@ -10,13 +12,8 @@
 
 namespace Nutcrackz {
 
-	bool VideoRenderer::m_HasInitializedTimer = false;
-	double VideoRenderer::m_RestartPointFromPause = 0.0;
-	double VideoRenderer::m_PresentationTimeInSeconds = 0.0;
-	double VideoRenderer::m_VideoDuration = 0.0;
-	bool VideoRenderer::m_IsRenderingVideo = false;
-	int64_t VideoRenderer::m_FramePosition = 0;
-	bool VideoRenderer::m_SeekAudio = false;
+	Ref<VideoClock> VideoRenderer::m_Clock = VideoClock::CreateSteady();
+	double VideoRenderer::m_AudioDriftThreshold = 0.04;
 
 	struct VideoVertex
 	{
@@ -25,6 +22,7 @@ namespace Nutcrackz {
 		glm::vec2 TexCoord;
 		glm::vec2 TilingFactor;
 		float TexIndex;
+		int PixelFormat;
 
 		// Editor-only
 		int EntityID;
@@ -74,6 +72,7 @@ namespace Nutcrackz {
 			{ ShaderDataType::Float2, "a_TexCoord"              },
 			{ ShaderDataType::Float2, "a_TilingFactor"          },
 			{ ShaderDataType::Float,  "a_TexIndex"              },
+			{ ShaderDataType::Int,    "a_PixelFormat"           },
 			{ ShaderDataType::Int,    "a_EntityID"              }
 		});
 		s_VideoData.VideoVertexArray->AddVertexBuffer(s_VideoData.VideoVertexBuffer);
@@ -104,7 +103,7 @@ namespace Nutcrackz {
 		uint32_t whiteVideoTextureData = 0xffffffff;
 		s_VideoData.WhiteVideoTexture->SetData(&whiteVideoTextureData, sizeof(uint32_t));
 
-		s_VideoData.VideoShader = Shader::Create("assets/shaders/Renderer2D_Quad.glsl");
+		s_VideoData.VideoShader = Shader::Create("assets/shaders/Renderer2D_Video.glsl");
 
 		// Set first texture slot to 0
 		s_VideoData.VideoTextureSlots[0] = s_VideoData.WhiteVideoTexture;
@@ -122,6 +121,9 @@ namespace Nutcrackz {
 		//NZ_PROFILE_FUNCTION();
 		 
 		delete[] s_VideoData.VideoVertexBufferBase;
+
+		AudioMixer::Shutdown();
+		VideoWorkerPool::Shutdown();
 	}
 
 	void VideoRenderer::BeginScene(const Camera& camera, const glm::mat4& transform)
@@ -184,63 +186,13 @@ namespace Nutcrackz {
 		StartBatch();
 	}
 
-#pragma region FromGLFW
-
-	// Because of the way ImGui uses GLFW's SetTime(),
-	// i cannot use it in here, unless i copied the entire Timer structure that GLFW uses
-	// in order to make it work! So that's what i did!
-	struct VideoTimer
-	{
-		uint64_t Offset;
-
-		struct VideoTimerWin32
-		{
-			bool HasPC;
-			uint64_t Frequency;
-
-		} win32;
-
-	} timer;
-
-	void InitTimerWin32()
-	{
-		uint64_t frequency;
-
-		if (QueryPerformanceFrequency((LARGE_INTEGER*)&frequency))
-		{
-			timer.win32.HasPC = true;
-			timer.win32.Frequency = frequency;
-		}
-		else
-		{
-			timer.win32.HasPC = false;
-			timer.win32.Frequency = 1000;
-		}
-	}
-
-	uint64_t PlatformGetTimerValue()
-	{
-		if (timer.win32.HasPC)
-		{
-			uint64_t value;
-			QueryPerformanceCounter((LARGE_INTEGER*)&value);
-			return value;
-		}
-		else
-			return (uint64_t)timeGetTime();
-	}
-
-	uint64_t PlatformGetTimerFrequency()
-	{
-		return timer.win32.Frequency;
-	}
-
-	double GetTime()
+	// The offset lives in each video's VideoPlaybackState, so every video runs on its own clock
+	double GetTime(const VideoPlaybackState& playback)
 	{
-		return (double)(PlatformGetTimerValue() - timer.Offset) / PlatformGetTimerFrequency();
+		return (double)(VideoRenderer::GetClock()->GetTicks() - playback.TimerOffset) / VideoRenderer::GetClock()->GetFrequency();
 	}
 
-	void SetTime(double time)
+	void SetTime(VideoPlaybackState& playback, double time)
 	{
 		if (time != time || time < 0.0 || time > 18446744073.0)
 		{
@@ -248,96 +200,95 @@ namespace Nutcrackz {
 			return;
 		}
 
-		timer.Offset = PlatformGetTimerValue() - (uint64_t)(time * PlatformGetTimerFrequency());
+		// Unsigned wrap-around keeps this right even when the clock hasn't reached time yet
+		playback.TimerOffset = VideoRenderer::GetClock()->GetTicks() - (uint64_t)(time * VideoRenderer::GetClock()->GetFrequency());
 	}
 
-#pragma endregion
-
 	void VideoRenderer::RenderVideo(const glm::mat4& transform, VideoRendererComponent& src, int entityID)
 	{
-		if (!m_HasInitializedTimer)
-		{
-			InitTimerWin32();
-			m_HasInitializedTimer = true;
-		}
-
 		constexpr size_t quadVertexCount = 4;
 		constexpr glm::vec2 textureCoords[] = { { 0.0f, 1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f }, { 0.0f, 0.0f }, };
 
 		float textureIndex = 0.0f;
+		int pixelFormat = 0;
 		const glm::vec2 tilingFactor(1.0f);
 
-		// This if statement is very much required!
-		// Because without it, this function creates a big memory leak!
-		if (src.VideoRendererID)
-			src.Video->DeleteRendererID(src.VideoRendererID);
-
 		if (src.Video)
 		{
+			auto& playback = src.Video->GetPlaybackState();
+
+			if (src.Video->IsLooping() != src.RepeatVideo)
+				src.Video->SetLooping(src.RepeatVideo);
+
 			if (src.UseVideoAudio)
 			{
-				src.Video->ReadAndPlayAudio(&src.Video->GetVideoState(), m_FramePosition, m_SeekAudio, src.PauseVideo);
+				src.Video->ReadAndPlayAudio(&src.Video->GetVideoState(), playback.FramePosition, playback.SeekAudio, src.PauseVideo);
 			}
 
-			if (!m_IsRenderingVideo)
+			if (!playback.IsRenderingVideo)
 			{
-				SetTime(0.0);
-				m_IsRenderingVideo = true;
+				SetTime(playback, 0.0);
+				playback.IsRenderingVideo = true;
 			}
 
-			if (m_FramePosition != 0)
+			if (playback.FramePosition != 0)
 			{
-				SetTime(src.FramePosition / src.Video->GetVideoState().Framerate);
+				SetTime(playback, src.FramePosition / src.Video->GetVideoState().Framerate);
 
-				if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), m_FramePosition))
+				if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), playback.FramePosition))
 				{
 					NZ_CORE_WARN("Could not seek video back to start frame!");
 					return;
 				}
 
-				src.PresentationTimeStamp = m_FramePosition;
-				m_FramePosition = 0;
+				src.PresentationTimeStamp = playback.FramePosition;
+				playback.FramePosition = 0;
 			}
 
-			src.VideoRendererID = src.Video->GetIDFromTexture(src.VideoFrameData, &src.PresentationTimeStamp, src.PauseVideo);
-			src.Video->SetRendererID(src.VideoRendererID);
+			int64_t clockPts = AV_NOPTS_VALUE;
 
-			if (src.PauseVideo)
+			if (!src.PauseVideo)
 			{
-				if (src.UseVideoAudio)
-				{
-					if (!src.Video->AVReaderSeekFrame(&src.Video->GetVideoState(), src.PresentationTimeStamp))
-					{
-						NZ_CORE_WARN("Could not seek a/v back to start frame!");
-						return;
-					}
-				}
-				else
+				if (playback.RestartPointFromPause > GetTime(playback))
+					SetTime(playback, playback.RestartPointFromPause);
+
+				if (playback.RestartPointFromPause < GetTime(playback))
+					playback.RestartPointFromPause = GetTime(playback);
+
+				// The audio clock only moves once per device period, so the video keeps running on its own smooth clock
+				// and that one gets pulled onto the audio whenever the two drift apart
+				double audioClock;
+				if (src.UseVideoAudio && src.Video->GetAudioClock(audioClock) && std::abs(GetTime(playback) - audioClock) > m_AudioDriftThreshold)
 				{
-					if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), src.PresentationTimeStamp))
-					{
-						NZ_CORE_WARN("Could not seek video back to start frame!");
-						return;
-					}
+					SetTime(playback, audioClock);
+					playback.RestartPointFromPause = audioClock;
 				}
 
-				SetTime(0.0);
+				// Whatever frame is due by now gets shown, the render thread never waits for the video
+				clockPts = (int64_t)(GetTime(playback) / av_q2d(src.Video->GetVideoState().TimeBase));
+			}
+
+			src.VideoRendererID = src.Video->GetIDFromTexture(src.VideoFrameData, &src.PresentationTimeStamp, src.PauseVideo, clockPts);
+
+			if (src.PauseVideo)
+			{
+				// The decoder stays where it is and the texture keeps the paused frame, only the clock is held
+				// so playback picks up from RestartPointFromPause once the video is resumed
+				SetTime(playback, 0.0);
 			}
 			else if (!src.PauseVideo)
 			{
-				if (m_RestartPointFromPause > GetTime())
-					SetTime(m_RestartPointFromPause);
-
-				if (m_RestartPointFromPause < GetTime())
-					m_RestartPointFromPause = GetTime();
+				playback.PresentationTimeInSeconds = src.PresentationTimeStamp * ((double)src.Video->GetVideoState().TimeBase.num / (double)src.Video->GetVideoState().TimeBase.den);
 
-				m_PresentationTimeInSeconds = src.PresentationTimeStamp * ((double)src.Video->GetVideoState().TimeBase.num / (double)src.Video->GetVideoState().TimeBase.den);
+				// Timestamps keep counting up across loop points
+				if (src.RepeatVideo && src.Video->GetLoopDuration() > 0.0)
+					playback.PresentationTimeInSeconds = std::fmod(playback.PresentationTimeInSeconds, src.Video->GetLoopDuration());
 				
 				int hoursToSeconds = src.Video->GetVideoState().Hours * 3600;
 				int minutesToSeconds = src.Video->GetVideoState().Mins * 60;
 				
-				if (m_VideoDuration != hoursToSeconds + minutesToSeconds + src.Video->GetVideoState().Secs + (0.01 * ((100 * src.Video->GetVideoState().Us) / AV_TIME_BASE)))
-					m_VideoDuration = hoursToSeconds + minutesToSeconds + src.Video->GetVideoState().Secs + (0.01 * ((100 * src.Video->GetVideoState().Us) / AV_TIME_BASE));
+				if (playback.VideoDuration != hoursToSeconds + minutesToSeconds + src.Video->GetVideoState().Secs + (0.01 * ((100 * src.Video->GetVideoState().Us) / AV_TIME_BASE)))
+					playback.VideoDuration = hoursToSeconds + minutesToSeconds + src.Video->GetVideoState().Secs + (0.01 * ((100 * src.Video->GetVideoState().Us) / AV_TIME_BASE));
 
 				if (src.Hours != src.Video->GetVideoState().Hours)
 					src.Hours = src.Video->GetVideoState().Hours;
@@ -352,13 +303,10 @@ namespace Nutcrackz {
 					src.Milliseconds = src.Video->GetVideoState().Us;
 
 				NZ_CORE_WARN("Presentation timestamp = {0}, Timebase num/den = {1}", src.PresentationTimeStamp, ((double)src.Video->GetVideoState().TimeBase.num / (double)src.Video->GetVideoState().TimeBase.den));
-				
-				while (m_PresentationTimeInSeconds > GetTime())
-				{
-					Sleep(m_PresentationTimeInSeconds - GetTime());
-				}
 
-				if (src.RepeatVideo && GetTime() > m_VideoDuration)
+				// Looping is normally done by the demuxer without a gap, this is only left for when it never wrapped around,
+				// e.g. because repeating was turned on after the end had already been decoded
+				if (src.RepeatVideo && GetTime(playback) > playback.VideoDuration && src.Video->GetLoopCount() == 0)
 				{
 					if (src.UseVideoAudio)
 					{
@@ -381,8 +329,8 @@ namespace Nutcrackz {
 
 					src.PresentationTimeStamp = 0;
 					src.FramePosition = 0;
-					SetTime(0.0);
-					m_RestartPointFromPause = 0.0;
+					SetTime(playback, 0.0);
+					playback.RestartPointFromPause = 0.0;
 				}
 			}
 
@@ -391,7 +339,7 @@ namespace Nutcrackz {
 
 			for (uint32_t i = 1; i < s_VideoData.VideoTextureSlotIndex; i++)
 			{
-				if (*s_VideoData.VideoTextureSlots[i] == *src.Video)
+				if (s_VideoData.VideoTextureSlots[i] && *s_VideoData.VideoTextureSlots[i] == *src.Video)
 				{
 					textureIndex = (float)i;
 					break;
@@ -400,7 +348,10 @@ namespace Nutcrackz {
 
 			if (textureIndex == 0.0f)
 			{
-				if (s_VideoData.VideoTextureSlotIndex >= VideoRendererData::MaxTextureSlots)
+				// YUV videos take up three consecutive slots (Y, U and V)
+				const uint32_t slotCount = src.Video->GetTextureSlotCount();
+
+				if (s_VideoData.VideoTextureSlotIndex + slotCount > VideoRendererData::MaxTextureSlots)
 					NextBatch();
 
 				textureIndex = (float)s_VideoData.VideoTextureSlotIndex;
@@ -410,8 +361,14 @@ namespace Nutcrackz {
 				else
 					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex] = s_VideoData.WhiteVideoTexture;
 
-				s_VideoData.VideoTextureSlotIndex++;
+				// The chroma planes are bound by the video itself, so nothing else may claim these slots
+				for (uint32_t i = 1; i < slotCount; i++)
+					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex + i] = nullptr;
+
+				s_VideoData.VideoTextureSlotIndex += slotCount;
 			}
+
+			pixelFormat = src.Video->GetShaderPixelFormat();
 		}
 		
 		for (size_t i = 0; i < quadVertexCount; i++)
@@ -421,6 +378,7 @@ namespace Nutcrackz {
 			s_VideoData.VideoVertexBufferPtr->TexCoord = textureCoords[i];
 			s_VideoData.VideoVertexBufferPtr->TilingFactor = tilingFactor;
 			s_VideoData.VideoVertexBufferPtr->TexIndex = textureIndex;
+			s_VideoData.VideoVertexBufferPtr->PixelFormat = pixelFormat;
 			s_VideoData.VideoVertexBufferPtr->EntityID = entityID;
 			s_VideoData.VideoVertexBufferPtr++;
 		}
@@ -432,6 +390,7 @@ namespace Nutcrackz {
 	{
 		constexpr size_t videoVertexCount = 4;
 		float textureIndex = 0.0f;
+		int pixelFormat = 0;
 
 		const glm::vec2 tilingFactor(1.0f);
 
@@ -439,42 +398,29 @@ namespace Nutcrackz {
 
 		if (src.Video)
 		{
-			if (m_FramePosition != src.FramePosition * src.Video->GetVideoState().VideoPacketDuration)
+			auto& playback = src.Video->GetPlaybackState();
+
+			if (playback.FramePosition != src.FramePosition * src.Video->GetVideoState().VideoPacketDuration)
 			{
-				m_FramePosition = src.FramePosition * src.Video->GetVideoState().VideoPacketDuration;
+				playback.FramePosition = src.FramePosition * src.Video->GetVideoState().VideoPacketDuration;
 			}
 
-			if (m_IsRenderingVideo)
+			if (playback.IsRenderingVideo)
 			{
-				if (src.UseVideoAudio)
-				{
-					if (!src.Video->AVReaderSeekFrame(&src.Video->GetVideoState(), 0, true))
-					{
-						NZ_CORE_WARN("Could not seek a/v back to start frame!");
-						return;
-					}
-
-					src.Video->CloseAudio(&src.Video->GetVideoState());
-				}
-				else
+				// Everything stays open, so playing again only has to start the threads
+				if (!src.Video->StopAndRewind(&src.Video->GetVideoState()))
 				{
-					if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), 0))
-					{
-						NZ_CORE_WARN("Could not seek video back to start frame!");
-						return;
-					}
+					NZ_CORE_WARN("Could not rewind video back to start frame!");
+					return;
 				}
 
-				src.Video->DeleteRendererID(src.VideoRendererID);
-				src.Video->CloseVideo(&src.Video->GetVideoState());
 				src.VideoRendererID = src.Video->GetIDFromTexture(src.VideoFrameData, &src.PresentationTimeStamp, src.PauseVideo);
-				src.Video->SetRendererID(src.VideoRendererID);
 
-				m_SeekAudio = true;
+				playback.SeekAudio = true;
 				src.PresentationTimeStamp = 0;
-				SetTime(0.0);
-				m_RestartPointFromPause = 0.0;
-				m_IsRenderingVideo = false;
+				SetTime(playback, 0.0);
+				playback.RestartPointFromPause = 0.0;
+				playback.IsRenderingVideo = false;
 			}
 
 			if (src.NumberOfFrames != src.Video->GetVideoState().NumberOfFrames)
@@ -497,7 +443,7 @@ namespace Nutcrackz {
 
 			for (uint32_t i = 1; i < s_VideoData.VideoTextureSlotIndex; i++)
 			{
-				if (*s_VideoData.VideoTextureSlots[i] == *src.Video)
+				if (s_VideoData.VideoTextureSlots[i] && *s_VideoData.VideoTextureSlots[i] == *src.Video)
 				{
 					textureIndex = (float)i;
 					break;
@@ -506,7 +452,10 @@ namespace Nutcrackz {
 
 			if (textureIndex == 0.0f)
 			{
-				if (s_VideoData.VideoTextureSlotIndex >= VideoRendererData::MaxTextureSlots)
+				// YUV videos take up three consecutive slots (Y, U and V)
+				const uint32_t slotCount = src.Video->GetTextureSlotCount();
+
+				if (s_VideoData.VideoTextureSlotIndex + slotCount > VideoRendererData::MaxTextureSlots)
 					NextBatch();
 
 				textureIndex = (float)s_VideoData.VideoTextureSlotIndex;
@@ -518,8 +467,14 @@ namespace Nutcrackz {
 				else
 					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex] = s_VideoData.WhiteVideoTexture;
 
-				s_VideoData.VideoTextureSlotIndex++;
+				// The chroma planes are bound by the video itself, so nothing else may claim these slots
+				for (uint32_t i = 1; i < slotCount; i++)
+					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex + i] = nullptr;
+
+				s_VideoData.VideoTextureSlotIndex += slotCount;
 			}
+
+			pixelFormat = src.Video->GetShaderPixelFormat();
 		}
 
 		for (size_t i = 0; i < videoVertexCount; i++)
@@ -529,6 +484,7 @@ namespace Nutcrackz {
 			s_VideoData.VideoVertexBufferPtr->TexCoord = textureCoords[i];
 			s_VideoData.VideoVertexBufferPtr->TilingFactor = tilingFactor;
 			s_VideoData.VideoVertexBufferPtr->TexIndex = textureIndex;
+			s_VideoData.VideoVertexBufferPtr->PixelFormat = pixelFormat;
 			s_VideoData.VideoVertexBufferPtr->EntityID = entityID;
 			s_VideoData.VideoVertexBufferPtr++;
 		}
@@ -540,6 +496,7 @@ namespace Nutcrackz {
 	{
 		constexpr size_t videoVertexCount = 4;
 		float textureIndex = 0.0f;
+		int pixelFormat = 0;
 
 		const glm::vec2 tilingFactor(1.0f);
 
@@ -547,6 +504,8 @@ namespace Nutcrackz {
 
 		if (src.Video)
 		{
+			auto& playback = src.Video->GetPlaybackState();
+
 			if (src.NumberOfFrames != src.Video->GetVideoState().NumberOfFrames)
 				src.NumberOfFrames = src.Video->GetVideoState().NumberOfFrames;
 
@@ -562,40 +521,43 @@ namespace Nutcrackz {
 			if (src.Milliseconds != src.Video->GetVideoState().Us)
 				src.Milliseconds = src.Video->GetVideoState().Us;
 
-			if (m_FramePosition != src.FramePosition * src.Video->GetVideoState().VideoPacketDuration)
+			const int64_t framePts = src.Video->GetFramePts(src.FramePosition);
+
+			if (playback.FramePosition != framePts)
 			{
-				if (m_IsRenderingVideo)
+				if (playback.IsRenderingVideo)
 				{
-					if (src.UseVideoAudio)
+					if (!src.Video->StopAndRewind(&src.Video->GetVideoState()))
 					{
-						src.Video->CloseAudio(&src.Video->GetVideoState());
-
-						if (!src.Video->AVReaderSeekFrame(&src.Video->GetVideoState(), 0, true))
-						{
-							NZ_CORE_WARN("Could not seek a/v back to start frame!");
-							return;
-						}
+						NZ_CORE_WARN("Could not rewind video back to start frame!");
+						return;
 					}
 
-					m_SeekAudio = true;
-					SetTime(0.0);
-					m_RestartPointFromPause = 0.0;
-					m_IsRenderingVideo = false;
+					playback.SeekAudio = true;
+					SetTime(playback, 0.0);
+					playback.RestartPointFromPause = 0.0;
+					playback.IsRenderingVideo = false;
 				}
 
-				m_FramePosition = src.FramePosition * src.Video->GetVideoState().VideoPacketDuration;
+				playback.FramePosition = framePts;
 
-				if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), m_FramePosition))
+				if (src.Video->PresentCachedFrame(src.FramePosition))
 				{
-					NZ_CORE_WARN("Could not seek video back to start frame!");
-					return;
+					src.PresentationTimeStamp = playback.FramePosition;
+					src.VideoRendererID = src.Video->GetRendererID();
 				}
+				else
+				{
+					if (!src.Video->VideoReaderSeekFrame(&src.Video->GetVideoState(), playback.FramePosition))
+					{
+						NZ_CORE_WARN("Could not seek video back to start frame!");
+						return;
+					}
 
-				src.PresentationTimeStamp = m_FramePosition;
+					src.PresentationTimeStamp = playback.FramePosition;
 
-				src.Video->DeleteRendererID(src.VideoRendererID);
-				src.VideoRendererID = src.Video->GetIDFromTexture(src.VideoFrameData, &src.PresentationTimeStamp, src.PauseVideo);
-				src.Video->SetRendererID(src.VideoRendererID);
+					src.VideoRendererID = src.Video->GetIDFromTexture(src.VideoFrameData, &src.PresentationTimeStamp, src.PauseVideo);
+				}
 			}
 
 			if (s_VideoData.VideoIndexCount >= VideoRendererData::MaxIndices)
@@ -603,7 +565,7 @@ namespace Nutcrackz {
 
 			for (uint32_t i = 1; i < s_VideoData.VideoTextureSlotIndex; i++)
 			{
-				if (*s_VideoData.VideoTextureSlots[i] == *src.Video)
+				if (s_VideoData.VideoTextureSlots[i] && *s_VideoData.VideoTextureSlots[i] == *src.Video)
 				{
 					textureIndex = (float)i;
 					break;
@@ -612,7 +574,10 @@ namespace Nutcrackz {
 
 			if (textureIndex == 0.0f)
 			{
-				if (s_VideoData.VideoTextureSlotIndex >= VideoRendererData::MaxTextureSlots)
+				// YUV videos take up three consecutive slots (Y, U and V)
+				const uint32_t slotCount = src.Video->GetTextureSlotCount();
+
+				if (s_VideoData.VideoTextureSlotIndex + slotCount > VideoRendererData::MaxTextureSlots)
 					NextBatch();
 
 				textureIndex = (float)s_VideoData.VideoTextureSlotIndex;
@@ -624,8 +589,14 @@ namespace Nutcrackz {
 				else
 					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex] = s_VideoData.WhiteVideoTexture;
 
-				s_VideoData.VideoTextureSlotIndex++;
+				// The chroma planes are bound by the video itself, so nothing else may claim these slots
+				for (uint32_t i = 1; i < slotCount; i++)
+					s_VideoData.VideoTextureSlots[s_VideoData.VideoTextureSlotIndex + i] = nullptr;
+
+				s_VideoData.VideoTextureSlotIndex += slotCount;
 			}
+
+			pixelFormat = src.Video->GetShaderPixelFormat();
 		}
 
 		for (size_t i = 0; i < videoVertexCount; i++)
@@ -635,6 +606,7 @@ namespace Nutcrackz {
 			s_VideoData.VideoVertexBufferPtr->TexCoord = textureCoords[i];
 			s_VideoData.VideoVertexBufferPtr->TilingFactor = tilingFactor;
 			s_VideoData.VideoVertexBufferPtr->TexIndex = textureIndex;
+			s_VideoData.VideoVertexBufferPtr->PixelFormat = pixelFormat;
 			s_VideoData.VideoVertexBufferPtr->EntityID = entityID;
 			s_VideoData.VideoVertexBufferPtr++;
 		}
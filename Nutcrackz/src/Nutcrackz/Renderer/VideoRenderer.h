@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Nutcrackz/Scene/Components.h"
+#include "Nutcrackz/Video/VideoClock.h"
 
 namespace Nutcrackz {
 
@@ -20,6 +21,14 @@ namespace Nutcrackz {
 
 		static void ResetPacketDuration(VideoRendererComponent& src);
 
+		// Swap in a VirtualVideoClock to play back faster or slower than real time. Only change it while nothing is playing,
+		// every video's position is an offset on the clock that was current when it started.
+		static void SetClock(const Ref<VideoClock>& clock) { m_Clock = clock ? clock : VideoClock::CreateSteady(); }
+		static const Ref<VideoClock>& GetClock() { return m_Clock; }
+
+		// Videos with audio follow the audio clock, their own clock is only pulled onto it once the two are further apart than this
+		static void SetAudioDriftThreshold(double seconds) { m_AudioDriftThreshold = seconds; }
+
 	private:
 		static void StartBatch();
 		static void NextBatch();
@@ -29,13 +38,8 @@ namespace Nutcrackz {
 		static void RenderCertainFrame(const glm::mat4& transform, VideoRendererComponent& src, int entityID);
 
 	private:
-		static bool m_HasInitializedTimer;
-		static double m_RestartPointFromPause;
-		static double m_PresentationTimeInSeconds;
-		static double m_VideoDuration;
-		static bool m_IsRenderingVideo;
-		static int64_t m_FramePosition;
-		static bool m_SeekAudio;
+		static Ref<VideoClock> m_Clock;
+		static double m_AudioDriftThreshold;
 	};
 
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include "nzpch.h"
+#include "AudioConverter.h"
+
+namespace Nutcrackz {
+
+	AudioConverter::AudioConverter(int sampleRate, int channels)
+		: m_SampleRate(sampleRate), m_Channels(channels)
+	{
+	}
+
+	AudioConverter::~AudioConverter()
+	{
+		swr_free(&m_Context);
+		av_channel_layout_uninit(&m_InputLayout);
+	}
+
+	int AudioConverter::Convert(const AVFrame* frame, AudioRingBuffer& ring)
+	{
+		if (!Configure(frame))
+			return -1;
+
+		const uint8_t** input = (const uint8_t**)frame->extended_data;
+		int inputCount = frame->nb_samples;
+		int written = 0;
+
+		// The free part of the ring is two spans at most, the second one only where it wraps around
+		for (int span = 0; span < 2; span++)
+		{
+			uint32_t space;
+			uint8_t* output = ring.BeginWrite(space);
+
+			if (space == 0)
+				break;
+
+			const int converted = swr_convert(m_Context, &output, (int)space, input, inputCount);
+			if (converted < 0)
+				return converted;
+
+			ring.EndWrite((uint32_t)converted);
+			written += converted;
+
+			// The input is in, calling again only picks up what the first span had no room for
+			inputCount = 0;
+
+			if (converted < (int)space)
+				break;
+		}
+
+		return written;
+	}
+
+	void AudioConverter::Reset()
+	{
+		// Initializing again drops the buffered input and the filter history, the settings stay
+		if (m_Context)
+			swr_init(m_Context);
+	}
+
+	double AudioConverter::GetDelay() const
+	{
+		return m_Context ? (double)swr_get_delay(m_Context, m_SampleRate) / m_SampleRate : 0.0;
+	}
+
+	bool AudioConverter::Configure(const AVFrame* frame)
+	{
+		if (m_Context && frame->format == m_InputFormat && frame->sample_rate == m_InputSampleRate && av_channel_layout_compare(&frame->ch_layout, &m_InputLayout) == 0)
+			return true;
+
+		// Some containers only store how many channels there are, those get the usual layout for that count
+		AVChannelLayout inputLayout = {};
+		if (frame->ch_layout.order == AV_CHANNEL_ORDER_UNSPEC || !av_channel_layout_check(&frame->ch_layout))
+			av_channel_layout_default(&inputLayout, frame->ch_layout.nb_channels);
+		else
+			av_channel_layout_copy(&inputLayout, &frame->ch_layout);
+
+		AVChannelLayout outputLayout = {};
+		av_channel_layout_default(&outputLayout, m_Channels);
+
+		swr_free(&m_Context);
+		int response = swr_alloc_set_opts2(&m_Context, &outputLayout, AV_SAMPLE_FMT_FLT, m_SampleRate,
+			&inputLayout, (AVSampleFormat)frame->format, frame->sample_rate, 0, nullptr);
+
+		if (response >= 0)
+			response = swr_init(m_Context);
+
+		av_channel_layout_uninit(&inputLayout);
+		av_channel_layout_uninit(&outputLayout);
+
+		if (response < 0)
+		{
+			NZ_CORE_ERROR("Could not initialize SwrContext.");
+			swr_free(&m_Context);
+			return false;
+		}
+
+		m_InputFormat = (AVSampleFormat)frame->format;
+		m_InputSampleRate = frame->sample_rate;
+		av_channel_layout_uninit(&m_InputLayout);
+		av_channel_layout_copy(&m_InputLayout, &frame->ch_layout);
+
+		return true;
+	}
+
+}
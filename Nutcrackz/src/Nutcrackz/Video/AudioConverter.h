@@ -0,0 +1,50 @@
+#pragma once
+
+#include "AudioRingBuffer.h"
+
+extern "C" {
+	#include <libavutil/channel_layout.h>
+	#include <libavutil/frame.h>
+	#include <libswresample/swresample.h>
+}
+
+namespace Nutcrackz {
+
+	// Resampling stage of a VideoReaderState. Converts decoded frames to interleaved float at the output rate
+	// and channel count, straight into the PCM ring. The SwrContext is set up from the first frame and only
+	// rebuilt if the stream changes its format, nothing is allocated per frame.
+	class AudioConverter
+	{
+	public:
+		AudioConverter(int sampleRate, int channels);
+		~AudioConverter();
+
+		AudioConverter(const AudioConverter&) = delete;
+		AudioConverter& operator=(const AudioConverter&) = delete;
+
+		// Frames written, negative on error. What doesn't fit into the ring stays buffered and comes out with the next frame.
+		int Convert(const AVFrame* frame, AudioRingBuffer& ring);
+		// Drops everything still buffered, after a seek
+		void Reset();
+
+		// How far behind the frame passed to Convert() next its first written sample is, in seconds
+		double GetDelay() const;
+
+		int GetSampleRate() const { return m_SampleRate; }
+		int GetChannels() const { return m_Channels; }
+
+	private:
+		bool Configure(const AVFrame* frame);
+
+	private:
+		SwrContext* m_Context = nullptr;
+		int m_SampleRate = 0;
+		int m_Channels = 0;
+
+		// What the context was set up for
+		AVSampleFormat m_InputFormat = AV_SAMPLE_FMT_NONE;
+		int m_InputSampleRate = 0;
+		AVChannelLayout m_InputLayout = {};
+	};
+
+}
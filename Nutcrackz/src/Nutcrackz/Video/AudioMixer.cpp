@@ -0,0 +1,267 @@
+#include "nzpch.h"
+#include "AudioMixer.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define NZ_AUDIO_MIXER_SSE
+	#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+	#define NZ_AUDIO_MIXER_NEON
+	#include <arm_neon.h>
+#endif
+
+namespace Nutcrackz {
+
+	bool AudioMixer::Init()
+	{
+		if (m_IsInitialized)
+			return true;
+
+		// Leaving the channel count and rate at 0 gets the device's own, so the OS doesn't have to convert anything
+		ma_device_config deviceConfig = ma_device_config_init(ma_device_type_playback);
+		deviceConfig.playback.format = ma_format_f32;
+		deviceConfig.playback.channels = 0;
+		deviceConfig.sampleRate = 0;
+		deviceConfig.dataCallback = DataCallback;
+		deviceConfig.noPreSilencedOutputBuffer = MA_TRUE;
+
+		if (ma_device_init(NULL, &deviceConfig, &m_Device) != MA_SUCCESS)
+		{
+			NZ_CORE_ERROR("Failed to open playback device!");
+			return false;
+		}
+
+		m_SampleRate = m_Device.sampleRate;
+		m_Channels = m_Device.playback.channels;
+		m_Scratch = new float[(size_t)ScratchFrames * m_Channels];
+
+		if (ma_device_start(&m_Device) != MA_SUCCESS)
+		{
+			NZ_CORE_ERROR("Failed to start playback device!");
+			ma_device_uninit(&m_Device);
+
+			delete[] m_Scratch;
+			m_Scratch = nullptr;
+			return false;
+		}
+
+		// Whatever the callback has mixed is still this long from being heard
+		const ma_uint32 bufferedFrames = m_Device.playback.internalPeriodSizeInFrames * m_Device.playback.internalPeriods;
+		m_Latency = m_Device.playback.internalSampleRate ? (double)bufferedFrames / m_Device.playback.internalSampleRate : 0.0;
+
+		m_IsInitialized = true;
+		return true;
+	}
+
+	void AudioMixer::Shutdown()
+	{
+		if (!m_IsInitialized)
+			return;
+
+		// Stops the callback before anything it reads goes away
+		ma_device_uninit(&m_Device);
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			delete m_Sources.exchange(nullptr);
+			m_SourcesInUse = nullptr;
+			FreeRetiredSources();
+		}
+
+		delete[] m_Scratch;
+		m_Scratch = nullptr;
+
+		m_IsInitialized = false;
+	}
+
+	uint32_t AudioMixer::AddSource(const Ref<AudioRingBuffer>& buffer, float gain)
+	{
+		if (!buffer || !Init())
+			return 0;
+
+		if (buffer->GetBytesPerFrame() != m_Channels * sizeof(float))
+		{
+			NZ_CORE_ERROR("Audio source doesn't match the playback device format!");
+			return 0;
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		Ref<Source> source = CreateRef<Source>();
+		source->ID = m_NextSourceID++;
+		source->Buffer = buffer;
+		source->Gain = gain;
+
+		SourceList* sources = new SourceList();
+		if (const SourceList* current = m_Sources.load())
+			sources->Sources = current->Sources;
+
+		sources->Sources.push_back(source);
+		PublishSources(sources);
+
+		return source->ID;
+	}
+
+	void AudioMixer::RemoveSource(uint32_t sourceID)
+	{
+		if (sourceID == 0)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		const SourceList* current = m_Sources.load();
+		if (!current || !FindSource(sourceID))
+			return;
+
+		SourceList* sources = new SourceList();
+		for (const auto& source : current->Sources)
+		{
+			if (source->ID != sourceID)
+				sources->Sources.push_back(source);
+		}
+
+		PublishSources(sources);
+	}
+
+	void AudioMixer::SetSourceGain(uint32_t sourceID, float gain)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (Source* source = FindSource(sourceID))
+			source->Gain = gain;
+	}
+
+	void AudioMixer::SetSourcePaused(uint32_t sourceID, bool isPaused)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (Source* source = FindSource(sourceID))
+			source->IsPaused = isPaused;
+	}
+
+	AudioMixer::Source* AudioMixer::FindSource(uint32_t sourceID)
+	{
+		// Lists are only freed under m_Mutex, which the caller holds
+		const SourceList* sources = m_Sources.load();
+		if (!sources)
+			return nullptr;
+
+		for (const auto& source : sources->Sources)
+		{
+			if (source->ID == sourceID)
+				return source.get();
+		}
+
+		return nullptr;
+	}
+
+	void AudioMixer::PublishSources(SourceList* sources)
+	{
+		if (SourceList* previous = m_Sources.exchange(sources))
+			m_RetiredSources.push_back(previous);
+
+		FreeRetiredSources();
+	}
+
+	void AudioMixer::FreeRetiredSources()
+	{
+		// The callback either marked a list before the swap, then it keeps it, or it sees the new one when it checks again
+		const SourceList* inUse = m_SourcesInUse.load();
+
+		for (auto it = m_RetiredSources.begin(); it != m_RetiredSources.end();)
+		{
+			if (*it == inUse)
+			{
+				it++;
+				continue;
+			}
+
+			// Dropping the last reference to a removed source frees its ring here, never in the callback
+			delete *it;
+			it = m_RetiredSources.erase(it);
+		}
+	}
+
+	void AudioMixer::DataCallback(ma_device* device, void* output, const void* input, ma_uint32 frameCount)
+	{
+		float* mixed = (float*)output;
+		const uint32_t channels = m_Channels;
+
+		memset(mixed, 0, (size_t)frameCount * channels * sizeof(float));
+
+		// Mark the list before using it, and make sure it wasn't replaced in between
+		SourceList* sources = m_Sources.load();
+		while (true)
+		{
+			m_SourcesInUse.store(sources);
+
+			SourceList* current = m_Sources.load();
+			if (current == sources)
+				break;
+
+			sources = current;
+		}
+
+		if (sources)
+		{
+			for (const auto& source : sources->Sources)
+			{
+				if (source->IsPaused.load(std::memory_order_relaxed))
+					continue;
+
+				const float gain = source->Gain.load(std::memory_order_relaxed);
+
+				// A muted source is still read, the audio clock of its video has to keep moving
+				uint32_t framesMixed = 0;
+				while (framesMixed < frameCount)
+				{
+					const uint32_t requested = std::min(frameCount - framesMixed, ScratchFrames);
+					const uint32_t framesRead = source->Buffer->Read(m_Scratch, requested);
+
+					if (gain != 0.0f)
+						MixSamples(mixed + (size_t)framesMixed * channels, m_Scratch, framesRead * channels, gain);
+
+					framesMixed += framesRead;
+
+					// The rest of the period stays silent for this source
+					if (framesRead < requested)
+						break;
+				}
+			}
+		}
+
+		m_SourcesInUse.store(nullptr);
+
+		(void)device;
+		(void)input;
+	}
+
+	void AudioMixer::MixSamples(float* output, const float* input, uint32_t sampleCount, float gain)
+	{
+		uint32_t i = 0;
+
+#if defined(NZ_AUDIO_MIXER_SSE)
+		const __m128 gains = _mm_set1_ps(gain);
+
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			const __m128 first = _mm_add_ps(_mm_loadu_ps(output + i), _mm_mul_ps(_mm_loadu_ps(input + i), gains));
+			const __m128 second = _mm_add_ps(_mm_loadu_ps(output + i + 4), _mm_mul_ps(_mm_loadu_ps(input + i + 4), gains));
+			_mm_storeu_ps(output + i, first);
+			_mm_storeu_ps(output + i + 4, second);
+		}
+#elif defined(NZ_AUDIO_MIXER_NEON)
+		const float32x4_t gains = vdupq_n_f32(gain);
+
+		for (; i + 8 <= sampleCount; i += 8)
+		{
+			vst1q_f32(output + i, vmlaq_f32(vld1q_f32(output + i), vld1q_f32(input + i), gains));
+			vst1q_f32(output + i + 4, vmlaq_f32(vld1q_f32(output + i + 4), vld1q_f32(input + i + 4), gains));
+		}
+#endif
+
+		for (; i < sampleCount; i++)
+			output[i] += input[i] * gain;
+	}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Nutcrackz/Core/Base.h"
+
+#include "AudioRingBuffer.h"
+
+#include "miniaudio.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// The one playback device every video plays through. It runs at the device's native rate and channel count in 32-bit float,
+	// sources fill their ring in exactly that format and the device callback mixes them, each with its own gain.
+	// The device is opened with the first source and stays open, so sources coming and going never touch it.
+	class AudioMixer
+	{
+	public:
+		static bool Init();
+		static void Shutdown();
+		static bool IsInitialized() { return m_IsInitialized; }
+
+		// Opens the device if it isn't yet, 0 if that failed
+		static uint32_t AddSource(const Ref<AudioRingBuffer>& buffer, float gain = 1.0f);
+		static void RemoveSource(uint32_t sourceID);
+		static void SetSourceGain(uint32_t sourceID, float gain);
+		// A paused source isn't read from, whatever is in its ring stays there
+		static void SetSourcePaused(uint32_t sourceID, bool isPaused);
+
+		// The format every source has to deliver, only valid after Init()
+		static uint32_t GetSampleRate() { return m_SampleRate; }
+		static uint32_t GetChannels() { return m_Channels; }
+		// How long mixed PCM sits in the device before it's heard
+		static double GetLatency() { return m_Latency; }
+
+	private:
+		struct Source
+		{
+			uint32_t ID = 0;
+			Ref<AudioRingBuffer> Buffer;
+			std::atomic<float> Gain = 1.0f;
+			std::atomic<bool> IsPaused = false;
+		};
+
+		// Never changed once published, adding or removing a source publishes a new list
+		struct SourceList
+		{
+			std::vector<Ref<Source>> Sources;
+		};
+
+		static void DataCallback(ma_device* device, void* output, const void* input, ma_uint32 frameCount);
+		static void MixSamples(float* output, const float* input, uint32_t sampleCount, float gain);
+		static Source* FindSource(uint32_t sourceID);
+		static void PublishSources(SourceList* sources);
+		static void FreeRetiredSources();
+
+	private:
+		// Frames read from a source at a time, the callback splits larger periods
+		static const uint32_t ScratchFrames = 1024;
+
+		inline static ma_device m_Device;
+		inline static bool m_IsInitialized = false;
+		inline static uint32_t m_SampleRate = 0;
+		inline static uint32_t m_Channels = 0;
+		inline static double m_Latency = 0.0;
+		inline static float* m_Scratch = nullptr;
+
+		// The callback never locks. It marks the list it mixes as in use, and a replaced list is only freed
+		// by a later AddSource()/RemoveSource() once the callback has moved on from it.
+		inline static std::atomic<SourceList*> m_Sources = nullptr;
+		inline static std::atomic<SourceList*> m_SourcesInUse = nullptr;
+		inline static std::vector<SourceList*> m_RetiredSources;
+
+		// Only between the threads changing sources, the callback never takes it
+		inline static std::mutex m_Mutex;
+		inline static uint32_t m_NextSourceID = 1;
+	};
+
+}
@@ -0,0 +1,187 @@
+#include "nzpch.h"
+#include "AudioRingBuffer.h"
+
+namespace Nutcrackz {
+
+	AudioRingBuffer::~AudioRingBuffer()
+	{
+		Shutdown();
+	}
+
+	void AudioRingBuffer::Init(uint32_t capacityInFrames, uint32_t bytesPerFrame)
+	{
+		Shutdown();
+
+		m_Capacity = capacityInFrames;
+		m_BytesPerFrame = bytesPerFrame;
+		m_Buffer = new uint8_t[(size_t)capacityInFrames * bytesPerFrame];
+
+		m_WriteCursor.store(0);
+		m_ReadCursor.store(0);
+		m_DiscardCursor.store(0);
+		m_UnderrunCount.store(0);
+		m_EndOfStream.store(false);
+		m_HasClock.store(false);
+	}
+
+	void AudioRingBuffer::Shutdown()
+	{
+		delete[] m_Buffer;
+		m_Buffer = nullptr;
+		m_Capacity = 0;
+	}
+
+	uint32_t AudioRingBuffer::Write(const void* data, uint32_t frameCount)
+	{
+		if (!m_Buffer)
+			return 0;
+
+		const uint64_t write = m_WriteCursor.load(std::memory_order_relaxed);
+		const uint32_t space = m_Capacity - (uint32_t)(write - GetReusableCursor());
+		const uint32_t count = std::min(frameCount, space);
+
+		const uint32_t start = (uint32_t)(write % m_Capacity);
+		const uint32_t first = std::min(count, m_Capacity - start);
+
+		memcpy(m_Buffer + (size_t)start * m_BytesPerFrame, data, (size_t)first * m_BytesPerFrame);
+		memcpy(m_Buffer, (const uint8_t*)data + (size_t)first * m_BytesPerFrame, (size_t)(count - first) * m_BytesPerFrame);
+
+		m_WriteCursor.store(write + count, std::memory_order_release);
+		return count;
+	}
+
+	void AudioRingBuffer::Reset()
+	{
+		// The read cursor belongs to the consumer, so instead of moving it
+		// we tell it where the valid data starts again
+		m_DiscardCursor.store(m_WriteCursor.load(std::memory_order_relaxed));
+		m_EndOfStream.store(false, std::memory_order_release);
+		// The clock means nothing until the producer says where the new data starts
+		m_HasClock.store(false, std::memory_order_release);
+	}
+
+	void AudioRingBuffer::SetTimestamp(double seconds)
+	{
+		const uint32_t sequence = m_ClockSequence.load(std::memory_order_relaxed);
+		m_ClockSequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		m_ClockCursor.store(m_WriteCursor.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		m_ClockSeconds.store(seconds, std::memory_order_relaxed);
+
+		m_ClockSequence.store(sequence + 2, std::memory_order_release);
+		m_HasClock.store(true, std::memory_order_release);
+	}
+
+	uint32_t AudioRingBuffer::Read(void* output, uint32_t frameCount)
+	{
+		if (!m_Buffer)
+			return 0;
+
+		// Announced before looking at the discard cursor, see GetReusableCursor()
+		m_IsReading.store(true);
+
+		uint64_t read = m_ReadCursor.load(std::memory_order_relaxed);
+		const uint64_t discard = m_DiscardCursor.load();
+		const uint64_t write = m_WriteCursor.load(std::memory_order_acquire);
+
+		if (discard > read)
+			read = discard;
+
+		const uint32_t count = std::min(frameCount, (uint32_t)(write - read));
+
+		const uint32_t start = (uint32_t)(read % m_Capacity);
+		const uint32_t first = std::min(count, m_Capacity - start);
+
+		memcpy(output, m_Buffer + (size_t)start * m_BytesPerFrame, (size_t)first * m_BytesPerFrame);
+		memcpy((uint8_t*)output + (size_t)first * m_BytesPerFrame, m_Buffer, (size_t)(count - first) * m_BytesPerFrame);
+
+		m_ReadCursor.store(read + count, std::memory_order_release);
+		m_IsReading.store(false);
+
+		// Running dry at the end of the stream is expected, anywhere else the decoder fell behind
+		if (count < frameCount && !m_EndOfStream.load(std::memory_order_acquire))
+			m_UnderrunCount.fetch_add(1, std::memory_order_relaxed);
+
+		return count;
+	}
+
+	uint32_t AudioRingBuffer::GetAvailableRead() const
+	{
+		return (uint32_t)(m_WriteCursor.load(std::memory_order_acquire) - GetConsumedCursor());
+	}
+
+	bool AudioRingBuffer::GetReadTimestamp(uint32_t sampleRate, double& seconds) const
+	{
+		if (!m_HasClock.load(std::memory_order_acquire) || sampleRate == 0)
+			return false;
+
+		uint32_t sequence;
+		uint64_t clockCursor;
+		double clockSeconds;
+
+		do
+		{
+			sequence = m_ClockSequence.load(std::memory_order_acquire);
+			clockCursor = m_ClockCursor.load(std::memory_order_relaxed);
+			clockSeconds = m_ClockSeconds.load(std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_acquire);
+		} while ((sequence & 1) || sequence != m_ClockSequence.load(std::memory_order_relaxed));
+
+		// Frames before a reset are skipped, not played, so the consumer really is at the discard cursor then
+		const uint64_t read = GetConsumedCursor();
+
+		// PCM is continuous between timestamps, so the clock can count backwards from the last one too
+		seconds = clockSeconds + ((double)read - (double)clockCursor) / sampleRate;
+		return true;
+	}
+
+	uint8_t* AudioRingBuffer::BeginWrite(uint32_t& frameCount)
+	{
+		if (!m_Buffer)
+		{
+			frameCount = 0;
+			return nullptr;
+		}
+
+		const uint64_t write = m_WriteCursor.load(std::memory_order_relaxed);
+		const uint32_t space = m_Capacity - (uint32_t)(write - GetReusableCursor());
+		const uint32_t start = (uint32_t)(write % m_Capacity);
+
+		frameCount = std::min(space, m_Capacity - start);
+		return m_Buffer + (size_t)start * m_BytesPerFrame;
+	}
+
+	void AudioRingBuffer::EndWrite(uint32_t frameCount)
+	{
+		const uint64_t write = m_WriteCursor.load(std::memory_order_relaxed);
+		m_WriteCursor.store(write + frameCount, std::memory_order_release);
+	}
+
+	uint32_t AudioRingBuffer::GetAvailableWrite() const
+	{
+		const uint64_t used = m_WriteCursor.load(std::memory_order_acquire) - GetReusableCursor();
+		return m_Capacity - (uint32_t)used;
+	}
+
+	uint64_t AudioRingBuffer::GetConsumedCursor() const
+	{
+		return std::max(m_ReadCursor.load(std::memory_order_acquire), m_DiscardCursor.load(std::memory_order_acquire));
+	}
+
+	uint64_t AudioRingBuffer::GetReusableCursor() const
+	{
+		const uint64_t read = m_ReadCursor.load(std::memory_order_acquire);
+		const uint64_t discard = m_DiscardCursor.load();
+
+		// Once the consumer has read past a reset, its read cursor covers the discarded frames anyway
+		if (discard <= read)
+			return read;
+
+		// A Read() that loaded the cursors before the reset may still be copying out of the discarded frames.
+		// One that starts after this check is guaranteed to see the discard cursor and skip them, so they're
+		// only free while no Read() is running. A paused consumer never reads, a running one is done within a period.
+		return m_IsReading.load() ? read : discard;
+	}
+
+}
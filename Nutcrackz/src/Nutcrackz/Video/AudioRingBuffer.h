@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+
+namespace Nutcrackz {
+
+	// Wait-free single-producer/single-consumer ring of interleaved PCM frames.
+	// The audio thread writes, the device callback reads. Neither side ever locks or allocates,
+	// only Init() and Shutdown() touch the heap and they must not race with either side.
+	class AudioRingBuffer
+	{
+	public:
+		AudioRingBuffer() = default;
+		~AudioRingBuffer();
+
+		AudioRingBuffer(const AudioRingBuffer&) = delete;
+		AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+		void Init(uint32_t capacityInFrames, uint32_t bytesPerFrame);
+		void Shutdown();
+
+		// Producer side
+		uint32_t Write(const void* data, uint32_t frameCount);
+		// Writing in place: up to frameCount frames fit at the returned pointer, EndWrite() publishes what was filled.
+		// The span stops where the ring wraps, asking again gives the rest.
+		uint8_t* BeginWrite(uint32_t& frameCount);
+		void EndWrite(uint32_t frameCount);
+		void MarkEndOfStream() { m_EndOfStream.store(true, std::memory_order_release); }
+		// Drops everything written so far, the consumer skips ahead on its next Read()
+		void Reset();
+		// The next frame written plays at this stream time, the clock counts on from there
+		void SetTimestamp(double seconds);
+
+		// Consumer side
+		uint32_t Read(void* output, uint32_t frameCount);
+
+		uint32_t GetAvailableRead() const;
+		uint32_t GetAvailableWrite() const;
+		uint32_t GetCapacity() const { return m_Capacity; }
+		uint32_t GetBytesPerFrame() const { return m_BytesPerFrame; }
+
+		uint64_t GetUnderrunCount() const { return m_UnderrunCount.load(std::memory_order_relaxed); }
+		uint64_t GetFramesRead() const { return m_ReadCursor.load(std::memory_order_relaxed); }
+		uint64_t GetFramesWritten() const { return m_WriteCursor.load(std::memory_order_relaxed); }
+
+		// Stream time of the next frame the consumer reads, safe to call from any thread.
+		// False until the producer set a timestamp.
+		bool GetReadTimestamp(uint32_t sampleRate, double& seconds) const;
+
+	private:
+		// Where valid data starts for the consumer, whichever of the read and discard cursor is further
+		uint64_t GetConsumedCursor() const;
+		// Everything before it may be overwritten by the producer
+		uint64_t GetReusableCursor() const;
+
+	private:
+		uint8_t* m_Buffer = nullptr;
+		uint32_t m_Capacity = 0;
+		uint32_t m_BytesPerFrame = 0;
+
+		// Cursors only ever grow, the position in m_Buffer is cursor % capacity.
+		// Each one lives on its own cache line so producer and consumer don't fight over it.
+		alignas(64) std::atomic<uint64_t> m_WriteCursor = 0;
+		alignas(64) std::atomic<uint64_t> m_ReadCursor = 0;
+		alignas(64) std::atomic<uint64_t> m_DiscardCursor = 0;
+		// Set for the duration of Read(). Stores to it and to m_DiscardCursor are sequentially consistent,
+		// which is what lets the producer reuse discarded frames without waiting for the consumer.
+		std::atomic<bool> m_IsReading = false;
+		std::atomic<uint64_t> m_UnderrunCount = 0;
+		std::atomic<bool> m_EndOfStream = false;
+
+		// Written by the producer as one unit, readers retry while the sequence is odd or moved underneath them
+		std::atomic<uint32_t> m_ClockSequence = 0;
+		std::atomic<uint64_t> m_ClockCursor = 0;
+		std::atomic<double> m_ClockSeconds = 0.0;
+		std::atomic<bool> m_HasClock = false;
+	};
+
+}
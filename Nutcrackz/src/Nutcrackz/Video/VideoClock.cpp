@@ -0,0 +1,53 @@
+#include "nzpch.h"
+#include "VideoClock.h"
+
+#include <chrono>
+
+namespace Nutcrackz {
+
+	namespace Utils {
+
+		static int64_t GetSteadyNanoseconds()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+	}
+
+	Ref<VideoClock> VideoClock::CreateSteady()
+	{
+		return CreateRef<SteadyVideoClock>();
+	}
+
+	SteadyVideoClock::SteadyVideoClock()
+		: m_Start(Utils::GetSteadyNanoseconds())
+	{
+	}
+
+	uint64_t SteadyVideoClock::GetTicks() const
+	{
+		return (uint64_t)(Utils::GetSteadyNanoseconds() - m_Start);
+	}
+
+	uint64_t SteadyVideoClock::GetFrequency() const
+	{
+		return 1000000000;
+	}
+
+	void VirtualVideoClock::Advance(double seconds)
+	{
+		if (seconds <= 0.0)
+			return;
+
+		m_Ticks.fetch_add((uint64_t)(seconds * Frequency), std::memory_order_acq_rel);
+	}
+
+	void VirtualVideoClock::SetSeconds(double seconds)
+	{
+		// Playback assumes time never runs backwards
+		const uint64_t ticks = (uint64_t)(std::max(0.0, seconds) * Frequency);
+		if (ticks > m_Ticks.load(std::memory_order_acquire))
+			m_Ticks.store(ticks, std::memory_order_release);
+	}
+
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Nutcrackz/Core/Base.h"
+
+#include <atomic>
+
+namespace Nutcrackz {
+
+	// Monotonic time source that video playback is timed against
+	class VideoClock
+	{
+	public:
+		virtual ~VideoClock() = default;
+
+		virtual uint64_t GetTicks() const = 0;
+		virtual uint64_t GetFrequency() const = 0;
+
+		double GetSeconds() const { return (double)GetTicks() / GetFrequency(); }
+
+		static Ref<VideoClock> CreateSteady();
+	};
+
+	// Real time, on every platform std::chrono::steady_clock runs on
+	class SteadyVideoClock : public VideoClock
+	{
+	public:
+		SteadyVideoClock();
+
+		virtual uint64_t GetTicks() const override;
+		virtual uint64_t GetFrequency() const override;
+
+	private:
+		int64_t m_Start;
+	};
+
+	// Only moves when told to, so offline rendering and benchmarks can play back as fast as decoding allows
+	class VirtualVideoClock : public VideoClock
+	{
+	public:
+		virtual uint64_t GetTicks() const override { return m_Ticks.load(std::memory_order_acquire); }
+		virtual uint64_t GetFrequency() const override { return Frequency; }
+
+		void Advance(double seconds);
+		// Never moves the clock backwards
+		void SetSeconds(double seconds);
+
+	private:
+		// Nanoseconds, like the steady clock
+		static const uint64_t Frequency = 1000000000;
+
+		std::atomic<uint64_t> m_Ticks = 0;
+	};
+
+}
@@ -0,0 +1,69 @@
+#include "nzpch.h"
+#include "VideoColorConversion.h"
+
+namespace Nutcrackz {
+
+	// Keep in sync with c_YUVCoefficients in Renderer2D_Video.glsl!
+	static const YUVToRGBCoefficients s_YUVToRGBCoefficients[] =
+	{
+		{ 16, 298, 409, -100, -208, 516 }, // BT.601, limited range
+		{  0, 256, 359,  -88, -183, 454 }, // BT.601, full range
+		{ 16, 298, 459,  -55, -136, 541 }, // BT.709, limited range
+		{  0, 256, 403,  -48, -120, 475 }, // BT.709, full range
+	};
+
+	namespace Utils {
+
+		static int GetCoefficientIndex(VideoColorSpace colorSpace, VideoColorRange colorRange)
+		{
+			return (colorSpace == VideoColorSpace::BT709 ? 2 : 0) + (colorRange == VideoColorRange::Full ? 1 : 0);
+		}
+
+		static uint8_t ClampToByte(int value)
+		{
+			return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+		}
+
+	}
+
+	const YUVToRGBCoefficients& GetYUVToRGBCoefficients(VideoColorSpace colorSpace, VideoColorRange colorRange)
+	{
+		return s_YUVToRGBCoefficients[Utils::GetCoefficientIndex(colorSpace, colorRange)];
+	}
+
+	int GetVideoShaderFormat(VideoFrameFormat format, VideoColorSpace colorSpace, VideoColorRange colorRange, bool isLinear)
+	{
+		if (format == VideoFrameFormat::RGBA)
+			return 0;
+
+		// 1-4 are filtered linearly, 5-8 are the same conversions with nearest filtering
+		return 1 + Utils::GetCoefficientIndex(colorSpace, colorRange) + (isLinear ? 0 : 4);
+	}
+
+	void ConvertYUV420ToRGBA(const uint8_t* y, int yStride, const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+		int width, int height, uint8_t* dst, int dstStride, VideoColorSpace colorSpace, VideoColorRange colorRange)
+	{
+		const YUVToRGBCoefficients& k = GetYUVToRGBCoefficients(colorSpace, colorRange);
+
+		for (int row = 0; row < height; row++)
+		{
+			const uint8_t* yRow = y + (ptrdiff_t)row * yStride;
+			const uint8_t* uRow = u + (ptrdiff_t)(row >> 1) * uStride;
+			const uint8_t* vRow = v + (ptrdiff_t)(row >> 1) * vStride;
+			uint8_t* dstRow = dst + (ptrdiff_t)row * dstStride;
+
+			for (int col = 0; col < width; col++)
+			{
+				const int c = (yRow[col] - k.YOffset) * k.YScale;
+				const int d = uRow[col >> 1] - 128;
+				const int e = vRow[col >> 1] - 128;
+
+				dstRow[col * 4 + 0] = Utils::ClampToByte((c + k.RV * e + 128) >> 8);
+				dstRow[col * 4 + 1] = Utils::ClampToByte((c + k.GU * d + k.GV * e + 128) >> 8);
+				dstRow[col * 4 + 2] = Utils::ClampToByte((c + k.BU * d + 128) >> 8);
+				dstRow[col * 4 + 3] = 255;
+			}
+		}
+	}
+
+}
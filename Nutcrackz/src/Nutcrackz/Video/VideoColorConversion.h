@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Nutcrackz {
+
+	enum class VideoFrameFormat
+	{
+		// Converted to RGBA on the CPU, one RGBA8 texture
+		RGBA = 0,
+		// Y, U and V planes of 8-bit 4:2:0 video uploaded as three R8 textures and converted by the video shader
+		YUV420
+	};
+
+	enum class VideoColorSpace
+	{
+		BT601 = 0,
+		BT709
+	};
+
+	enum class VideoColorRange
+	{
+		Limited = 0,
+		Full
+	};
+
+	// Fixed point (8.8) YUV -> RGB coefficients.
+	// Renderer2D_Video.glsl carries the same table and the same integer math,
+	// so ConvertYUV420ToRGBA() produces exactly what the shader draws at 1:1 scale.
+	struct YUVToRGBCoefficients
+	{
+		int YOffset;
+		int YScale;
+		int RV;
+		int GU;
+		int GV;
+		int BU;
+	};
+
+	const YUVToRGBCoefficients& GetYUVToRGBCoefficients(VideoColorSpace colorSpace, VideoColorRange colorRange);
+
+	// Value of a_PixelFormat in Renderer2D_Video.glsl, 0 is a regular RGBA texture.
+	// The shader filters YUV frames itself, isLinear stands in for the texture's magnification filter there.
+	int GetVideoShaderFormat(VideoFrameFormat format, VideoColorSpace colorSpace, VideoColorRange colorRange, bool isLinear = true);
+
+	// CPU reference for the shader side conversion, mainly so the YUV path can be validated without a GPU
+	void ConvertYUV420ToRGBA(const uint8_t* y, int yStride, const uint8_t* u, int uStride, const uint8_t* v, int vStride,
+		int width, int height, uint8_t* dst, int dstStride, VideoColorSpace colorSpace, VideoColorRange colorRange);
+
+}
@@ -0,0 +1,136 @@
+#include "nzpch.h"
+#include "VideoConverter.h"
+
+#include "VideoWorkerPool.h"
+
+extern "C" {
+	#include <libavutil/pixdesc.h>
+}
+
+namespace Nutcrackz {
+
+	namespace Utils {
+
+		static int GetPlaneRow(const AVPixFmtDescriptor* desc, int plane, int row)
+		{
+			// Planes 1 and 2 of YUV formats are the (possibly subsampled) chroma planes
+			if ((plane == 1 || plane == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB))
+				return row >> desc->log2_chroma_h;
+
+			return row;
+		}
+
+		// swscale defaults to BT.601 limited range, which tints BT.709 clips and crushes full range ones.
+		// The destination is always full range RGB, ignored by swscale when the source isn't YUV.
+		static void SetColorDetails(SwsContext* context, VideoColorSpace colorSpace, VideoColorRange colorRange)
+		{
+			const int* srcCoefficients = sws_getCoefficients(colorSpace == VideoColorSpace::BT709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+			const int srcRange = colorRange == VideoColorRange::Full ? 1 : 0;
+
+			sws_setColorspaceDetails(context, srcCoefficients, srcRange, sws_getCoefficients(SWS_CS_DEFAULT), 1, 0, 1 << 16, 1 << 16);
+		}
+
+	}
+
+	VideoConverter::~VideoConverter()
+	{
+		ClearCache();
+	}
+
+	bool VideoConverter::Convert(const AVFrame* frame, AVPixelFormat srcFormat, uint8_t* const dst[4], const int dstLineSize[4],
+		AVPixelFormat dstFormat, int dstWidth, int dstHeight, VideoColorSpace colorSpace, VideoColorRange colorRange)
+	{
+		ScalerKey key = { srcFormat, frame->width, frame->height, dstFormat, dstWidth, dstHeight, colorSpace, colorRange };
+		Scaler* scaler = GetScaler(key);
+
+		if (!scaler)
+		{
+			NZ_CORE_ERROR("Could not initialize SW Scaler!");
+			return false;
+		}
+
+		if (scaler->Slices.size() == 1)
+		{
+			sws_scale(scaler->Slices[0].Context, frame->data, frame->linesize, 0, frame->height, dst, dstLineSize);
+			return true;
+		}
+
+		const AVPixFmtDescriptor* srcDesc = av_pix_fmt_desc_get(srcFormat);
+		const AVPixFmtDescriptor* dstDesc = av_pix_fmt_desc_get(dstFormat);
+
+		// Every band is converted as if it was a small image of its own,
+		// so we only have to move the plane pointers to where the band starts
+		VideoWorkerPool::Run((uint32_t)scaler->Slices.size(), m_Concurrency, [&](uint32_t index)
+		{
+			const ScalerSlice& slice = scaler->Slices[index];
+
+			const uint8_t* srcSlice[4] = {};
+			uint8_t* dstSlice[4] = {};
+
+			for (int plane = 0; plane < 4; plane++)
+			{
+				if (frame->data[plane])
+					srcSlice[plane] = frame->data[plane] + (ptrdiff_t)frame->linesize[plane] * Utils::GetPlaneRow(srcDesc, plane, slice.Start);
+
+				if (dst[plane])
+					dstSlice[plane] = dst[plane] + (ptrdiff_t)dstLineSize[plane] * Utils::GetPlaneRow(dstDesc, plane, slice.Start);
+			}
+
+			sws_scale(slice.Context, srcSlice, frame->linesize, 0, slice.Height, dstSlice, dstLineSize);
+		});
+
+		return true;
+	}
+
+	void VideoConverter::ClearCache()
+	{
+		for (auto& [key, scaler] : m_Scalers)
+		{
+			for (auto& slice : scaler.Slices)
+				sws_freeContext(slice.Context);
+		}
+
+		m_Scalers.clear();
+	}
+
+	VideoConverter::Scaler* VideoConverter::GetScaler(const ScalerKey& key)
+	{
+		auto it = m_Scalers.find(key);
+		if (it != m_Scalers.end())
+			return &it->second;
+
+		Scaler scaler;
+
+		// Banding is only seamless when nothing gets resized vertically
+		const bool canSlice = key.SrcWidth == key.DstWidth && key.SrcHeight == key.DstHeight;
+		const uint32_t sliceCount = canSlice ? std::max(1u, std::min(VideoWorkerPool::GetThreadCount(), (uint32_t)(key.SrcHeight / MinSliceHeight))) : 1;
+
+		// Keep band starts on a 16 row boundary so they never split a subsampled chroma row
+		const int sliceHeight = sliceCount > 1 ? ((key.SrcHeight / (int)sliceCount) & ~15) : key.SrcHeight;
+
+		for (uint32_t i = 0; i < sliceCount; i++)
+		{
+			ScalerSlice slice;
+			slice.Start = i * sliceHeight;
+			slice.Height = i == sliceCount - 1 ? key.SrcHeight - slice.Start : sliceHeight;
+
+			const int dstHeight = sliceCount > 1 ? slice.Height : key.DstHeight;
+			slice.Context = sws_getContext(key.SrcWidth, slice.Height, key.SrcFormat, key.DstWidth, dstHeight, key.DstFormat, SWS_BILINEAR, NULL, NULL, NULL);
+
+			if (!slice.Context)
+			{
+				for (auto& created : scaler.Slices)
+					sws_freeContext(created.Context);
+
+				return nullptr;
+			}
+
+			Utils::SetColorDetails(slice.Context, key.ColorSpace, key.ColorRange);
+
+			scaler.Slices.push_back(slice);
+		}
+
+		return &m_Scalers.emplace(key, std::move(scaler)).first->second;
+	}
+
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+extern "C" {
+	#include <libavutil/frame.h>
+	#include <libavutil/pixfmt.h>
+	#include <libswscale/swscale.h>
+}
+
+#include "VideoColorConversion.h"
+
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// Colour conversion stage of a VideoReaderState.
+	// Scaler contexts are created once per (source format/size/colour space, destination format/size) and reused,
+	// and unscaled conversions are split into horizontal bands that are converted on the shared VideoWorkerPool.
+	class VideoConverter
+	{
+	public:
+		VideoConverter() = default;
+		~VideoConverter();
+
+		// YUV sources are converted with the matrix and range of colorSpace and colorRange, the same ones the video shader uses
+		bool Convert(const AVFrame* frame, AVPixelFormat srcFormat, uint8_t* const dst[4], const int dstLineSize[4],
+			AVPixelFormat dstFormat, int dstWidth, int dstHeight, VideoColorSpace colorSpace, VideoColorRange colorRange);
+
+		void ClearCache();
+
+		// Caps how many threads (the caller included) work on one conversion, the bands stay the same
+		void SetConcurrency(uint32_t concurrency) { m_Concurrency = std::max(1u, concurrency); }
+
+	private:
+		struct ScalerKey
+		{
+			AVPixelFormat SrcFormat;
+			int SrcWidth, SrcHeight;
+			AVPixelFormat DstFormat;
+			int DstWidth, DstHeight;
+			VideoColorSpace ColorSpace;
+			VideoColorRange ColorRange;
+
+			bool operator==(const ScalerKey& other) const
+			{
+				return SrcFormat == other.SrcFormat && SrcWidth == other.SrcWidth && SrcHeight == other.SrcHeight
+					&& DstFormat == other.DstFormat && DstWidth == other.DstWidth && DstHeight == other.DstHeight
+					&& ColorSpace == other.ColorSpace && ColorRange == other.ColorRange;
+			}
+		};
+
+		struct ScalerKeyHash
+		{
+			size_t operator()(const ScalerKey& key) const
+			{
+				size_t hash = std::hash<int>()(key.SrcFormat);
+				hash = hash * 31 + std::hash<int>()(key.SrcWidth);
+				hash = hash * 31 + std::hash<int>()(key.SrcHeight);
+				hash = hash * 31 + std::hash<int>()(key.DstFormat);
+				hash = hash * 31 + std::hash<int>()(key.DstWidth);
+				hash = hash * 31 + std::hash<int>()(key.DstHeight);
+				hash = hash * 31 + std::hash<int>()((int)key.ColorSpace);
+				hash = hash * 31 + std::hash<int>()((int)key.ColorRange);
+				return hash;
+			}
+		};
+
+		struct ScalerSlice
+		{
+			SwsContext* Context = nullptr;
+			int Start = 0;
+			int Height = 0;
+		};
+
+		struct Scaler
+		{
+			std::vector<ScalerSlice> Slices;
+		};
+
+		Scaler* GetScaler(const ScalerKey& key);
+
+	private:
+		// Bands smaller than this cost more in scheduling than they save
+		static const int MinSliceHeight = 64;
+
+		std::atomic<uint32_t> m_Concurrency = UINT32_MAX;
+		std::unordered_map<ScalerKey, Scaler, ScalerKeyHash> m_Scalers;
+	};
+
+}
@@ -0,0 +1,64 @@
+#include "nzpch.h"
+#include "VideoDecodeScheduler.h"
+
+#include <thread>
+
+namespace Nutcrackz {
+
+	std::atomic<uint32_t> VideoDecodeScheduler::m_CoreBudget = 0;
+	std::atomic<uint32_t> VideoDecodeScheduler::m_ActiveDecoders = 0;
+
+	void VideoDecodeScheduler::SetCoreBudget(uint32_t cores)
+	{
+		m_CoreBudget = cores;
+	}
+
+	uint32_t VideoDecodeScheduler::GetCoreBudget()
+	{
+		const uint32_t budget = m_CoreBudget;
+		return budget ? budget : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	void VideoDecodeScheduler::Register()
+	{
+		m_ActiveDecoders++;
+	}
+
+	void VideoDecodeScheduler::Unregister()
+	{
+		NZ_CORE_ASSERT(m_ActiveDecoders > 0, "Unregistered a video decoder that was never registered!");
+		m_ActiveDecoders--;
+	}
+
+	uint32_t VideoDecodeScheduler::GetThreadShare()
+	{
+		return std::max(1u, GetCoreBudget() / std::max(1u, m_ActiveDecoders.load()));
+	}
+
+	VideoDecodeThreading VideoDecodeScheduler::GetThreading(const AVCodec* codec)
+	{
+		VideoDecodeThreading threading;
+
+		const uint32_t share = GetThreadShare();
+		if (share < 2 || !codec)
+			return threading;
+
+		// Frame threading scales with any stream, slice threading only with streams that were encoded in slices
+		if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS)
+			threading.ThreadType = FF_THREAD_FRAME;
+		else if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS)
+			threading.ThreadType = FF_THREAD_SLICE;
+		else
+			return threading;
+
+		threading.ThreadCount = (int)share;
+		return threading;
+	}
+
+	void VideoDecodeScheduler::ApplyThreading(AVCodecContext* codecContext, const VideoDecodeThreading& threading)
+	{
+		codecContext->thread_count = threading.ThreadCount;
+		codecContext->thread_type = threading.ThreadType;
+	}
+
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+extern "C" {
+	#include <libavcodec/avcodec.h>
+}
+
+#include <atomic>
+
+namespace Nutcrackz {
+
+	// How a single decoder should be threaded
+	struct VideoDecodeThreading
+	{
+		int ThreadCount = 1;
+		// FF_THREAD_FRAME or FF_THREAD_SLICE, 0 when the decoder runs on the calling thread only
+		int ThreadType = 0;
+	};
+
+	// Splits one core budget between every open video decoder, instead of letting each of them
+	// spawn a thread per core. Every open decoder gets an equal share, which is also the number
+	// of threads its colour conversion may run on.
+	class VideoDecodeScheduler
+	{
+	public:
+		// 0 uses every hardware thread. The VideoWorkerPool takes its size from the budget when it starts,
+		// so set it before the first video is opened.
+		static void SetCoreBudget(uint32_t cores);
+		static uint32_t GetCoreBudget();
+
+		static void Register();
+		static void Unregister();
+		static uint32_t GetActiveDecoderCount() { return m_ActiveDecoders; }
+
+		static uint32_t GetThreadShare();
+		static VideoDecodeThreading GetThreading(const AVCodec* codec);
+		static void ApplyThreading(AVCodecContext* codecContext, const VideoDecodeThreading& threading);
+
+		// Threading is fixed once a decoder is open, so it's only rebalanced where the decoder is flushed anyway
+		static bool NeedsRebalance(const AVCodec* codec, int threadCount) { return GetThreading(codec).ThreadCount != threadCount; }
+
+	private:
+		static std::atomic<uint32_t> m_CoreBudget;
+		static std::atomic<uint32_t> m_ActiveDecoders;
+	};
+
+}
@@ -0,0 +1,368 @@
+#include "nzpch.h"
+#include "VideoDemuxer.h"
+
+namespace Nutcrackz {
+
+	VideoDemuxer::~VideoDemuxer()
+	{
+		Close();
+	}
+
+	bool VideoDemuxer::Open(const VideoSource& source)
+	{
+		Close();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_FormatContext = avformat_alloc_context();
+
+		if (!m_FormatContext)
+		{
+			NZ_CORE_ERROR("Could not create AVFormatContext!");
+			return false;
+		}
+
+		// Whatever can't be mapped still goes through FFmpeg's own file protocol, unless it's only part of a file
+		if ((m_UseMappedInput || source.IsPacked()) && m_MappedInput.Open(source))
+		{
+			m_FormatContext->pb = m_MappedInput.GetIOContext();
+			m_FormatContext->flags |= AVFMT_FLAG_CUSTOM_IO;
+		}
+		else if (source.IsPacked())
+		{
+			NZ_CORE_ERROR("Could not map video at offset {0} of {1}!", source.Offset, source.Path.string());
+			avformat_free_context(m_FormatContext);
+			m_FormatContext = nullptr;
+			return false;
+		}
+
+		VideoProbeKey probeKey;
+		const bool hasProbeKey = m_UseProbeCache && VideoProbeCache::GetKey(source, probeKey);
+		const AVInputFormat* cachedFormat = hasProbeKey ? VideoProbeCache::FindFormat(probeKey) : nullptr;
+
+		const int64_t probeSize = m_FormatContext->probesize;
+		const int64_t analyzeDuration = m_FormatContext->max_analyze_duration;
+
+		// Only the header is read when the streams are known already
+		if (cachedFormat)
+		{
+			m_FormatContext->probesize = CachedProbeSize;
+			m_FormatContext->max_analyze_duration = 1;
+		}
+
+		// avformat_open_input frees the context on failure
+		if (avformat_open_input(&m_FormatContext, source.Path.string().c_str(), cachedFormat, NULL) < 0)
+		{
+			NZ_CORE_ERROR("Could not open video file: {0}", source.Path.string().c_str());
+			m_MappedInput.Close();
+			return false;
+		}
+
+		if (!cachedFormat || !VideoProbeCache::Apply(probeKey, m_FormatContext))
+		{
+			m_FormatContext->probesize = probeSize;
+			m_FormatContext->max_analyze_duration = analyzeDuration;
+
+			if (avformat_find_stream_info(m_FormatContext, NULL) < 0)
+			{
+				NZ_CORE_ERROR("Could not find stream info!");
+				avformat_close_input(&m_FormatContext);
+				m_MappedInput.Close();
+				return false;
+			}
+
+			if (hasProbeKey)
+				VideoProbeCache::Store(probeKey, m_FormatContext);
+		}
+
+		// Nothing is demuxed until a decoder asks for it
+		for (unsigned int i = 0; i < m_FormatContext->nb_streams; i++)
+			m_FormatContext->streams[i]->discard = AVDISCARD_ALL;
+
+		m_Queues = std::vector<PacketQueue>(m_FormatContext->nb_streams);
+		m_IsEndOfFile = false;
+		m_SeekTarget = AV_NOPTS_VALUE;
+		m_LoopCount = 0;
+		m_LoopDuration = 0;
+
+		return true;
+	}
+
+	void VideoDemuxer::Close()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& queue : m_Queues)
+			FlushQueue(queue);
+
+		m_Queues.clear();
+
+		if (m_FormatContext)
+			avformat_close_input(&m_FormatContext);
+
+		// Custom I/O outlives the format context, FFmpeg leaves closing it to us
+		m_MappedInput.Close();
+	}
+
+	uint32_t VideoDemuxer::GetQueuedPacketCount(int streamIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (streamIndex < 0 || streamIndex >= (int)m_Queues.size())
+			return 0;
+
+		return (uint32_t)m_Queues[streamIndex].Packets.size();
+	}
+
+	void VideoDemuxer::AcquireStream(int streamIndex)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FormatContext || streamIndex < 0 || streamIndex >= (int)m_Queues.size())
+			return;
+
+		m_Queues[streamIndex].Holders++;
+		m_FormatContext->streams[streamIndex]->discard = AVDISCARD_DEFAULT;
+	}
+
+	void VideoDemuxer::ReleaseStream(int streamIndex)
+	{
+		bool isUnused = true;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (!m_FormatContext || streamIndex < 0 || streamIndex >= (int)m_Queues.size())
+				return;
+
+			PacketQueue& queue = m_Queues[streamIndex];
+
+			if (queue.Holders > 0 && --queue.Holders == 0)
+			{
+				FlushQueue(queue);
+				m_FormatContext->streams[streamIndex]->discard = AVDISCARD_ALL;
+			}
+
+			for (const auto& other : m_Queues)
+				isUnused &= other.Holders == 0;
+		}
+
+		if (isUnused)
+			Close();
+	}
+
+	int VideoDemuxer::ReadPacket(int streamIndex, AVPacket* packet)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FormatContext || streamIndex < 0 || streamIndex >= (int)m_Queues.size())
+			return AVERROR(EINVAL);
+
+		PacketQueue& queue = m_Queues[streamIndex];
+
+		while (queue.Packets.empty())
+		{
+			if (m_IsEndOfFile && !(m_IsLooping && RewindForLoop()))
+				return AVERROR_EOF;
+
+			const int response = av_read_frame(m_FormatContext, packet);
+
+			if (response < 0)
+			{
+				m_IsEndOfFile = response == AVERROR_EOF || avio_feof(m_FormatContext->pb);
+
+				if (!m_IsEndOfFile)
+					return response;
+
+				continue;
+			}
+
+			TrackEndTimestamp(packet);
+			AddLoopOffset(packet);
+
+			if (packet->stream_index == streamIndex)
+				return 0;
+
+			// Discarded streams never get here, so this one belongs to another decoder
+			PacketQueue& other = m_Queues[packet->stream_index];
+
+			if (other.Holders == 0)
+			{
+				av_packet_unref(packet);
+				continue;
+			}
+
+			AVPacket* queued = av_packet_alloc();
+			av_packet_move_ref(queued, packet);
+			other.Packets.push_back(queued);
+			other.Size += queued->size;
+
+			if (other.Size > MaxQueuedBytes)
+				TrimQueue(other, packet->stream_index);
+		}
+
+		AVPacket* queued = queue.Packets.front();
+		queue.Packets.pop_front();
+		queue.Size -= queued->size;
+
+		av_packet_move_ref(packet, queued);
+		av_packet_free(&queued);
+		return 0;
+	}
+
+	int VideoDemuxer::Seek(int streamIndex, int64_t timestamp, int flags, int64_t target)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FormatContext)
+			return AVERROR(EINVAL);
+
+		const int response = av_seek_frame(m_FormatContext, streamIndex, timestamp, flags);
+
+		for (auto& queue : m_Queues)
+			FlushQueue(queue);
+
+		m_IsEndOfFile = false;
+		m_SeekSerial++;
+
+		// Seek targets are always within the first pass
+		m_LoopCount = 0;
+
+		if (target == AV_NOPTS_VALUE)
+			m_SeekTarget = AV_NOPTS_VALUE;
+		else if (streamIndex >= 0)
+			m_SeekTarget = av_rescale_q(target, m_FormatContext->streams[streamIndex]->time_base, AV_TIME_BASE_Q);
+		else
+			m_SeekTarget = target;
+
+		return response;
+	}
+
+	void VideoDemuxer::GetSeekPoint(uint32_t& serial, int64_t& target)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		serial = m_SeekSerial;
+		target = m_SeekTarget;
+	}
+
+	uint32_t VideoDemuxer::GetSeekSerial()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_SeekSerial;
+	}
+
+	uint32_t VideoDemuxer::GetLoopCount()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_LoopCount;
+	}
+
+	int64_t VideoDemuxer::GetLoopDuration()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_LoopDuration;
+	}
+
+	void VideoDemuxer::TrackEndTimestamp(const AVPacket* packet)
+	{
+		if (packet->pts == AV_NOPTS_VALUE)
+			return;
+
+		const AVStream* stream = m_FormatContext->streams[packet->stream_index];
+		int64_t duration = packet->duration;
+
+		// Some containers leave the duration of video packets out, the next pass would start on top of the last frame then
+		if (duration <= 0 && stream->codecpar->codec_type == AVMEDIA_TYPE_VIDEO && stream->avg_frame_rate.num > 0)
+			duration = av_rescale_q(1, av_inv_q(stream->avg_frame_rate), stream->time_base);
+
+		PacketQueue& queue = m_Queues[packet->stream_index];
+		const int64_t end = av_rescale_q(packet->pts + std::max<int64_t>(duration, 0), stream->time_base, AV_TIME_BASE_Q);
+
+		if (queue.EndTimestamp == AV_NOPTS_VALUE || end > queue.EndTimestamp)
+			queue.EndTimestamp = end;
+	}
+
+	void VideoDemuxer::AddLoopOffset(AVPacket* packet)
+	{
+		if (m_LoopCount == 0)
+			return;
+
+		const int64_t offset = av_rescale_q(m_LoopCount * m_LoopDuration, AV_TIME_BASE_Q, m_FormatContext->streams[packet->stream_index]->time_base);
+
+		if (packet->pts != AV_NOPTS_VALUE)
+			packet->pts += offset;
+
+		if (packet->dts != AV_NOPTS_VALUE)
+			packet->dts += offset;
+	}
+
+	bool VideoDemuxer::RewindForLoop()
+	{
+		const int64_t startTime = m_FormatContext->start_time != AV_NOPTS_VALUE ? m_FormatContext->start_time : 0;
+
+		if (m_LoopDuration == 0)
+		{
+			// The video decides where a pass ends, so its last frame is followed right by its first one.
+			// Audio only files go by whichever stream is longest.
+			int64_t videoEnd = AV_NOPTS_VALUE;
+			int64_t end = AV_NOPTS_VALUE;
+
+			for (size_t i = 0; i < m_Queues.size(); i++)
+			{
+				const PacketQueue& queue = m_Queues[i];
+				if (queue.Holders == 0 || queue.EndTimestamp == AV_NOPTS_VALUE)
+					continue;
+
+				end = std::max(end, queue.EndTimestamp);
+
+				if (m_FormatContext->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO)
+					videoEnd = std::max(videoEnd, queue.EndTimestamp);
+			}
+
+			if (videoEnd != AV_NOPTS_VALUE)
+				end = videoEnd;
+
+			if (end == AV_NOPTS_VALUE || end <= startTime)
+				return false;
+
+			m_LoopDuration = end - startTime;
+		}
+
+		// Unlike Seek() the queues are kept, they still hold the end of the pass
+		if (av_seek_frame(m_FormatContext, -1, startTime, AVSEEK_FLAG_BACKWARD) < 0)
+			return false;
+
+		m_LoopCount++;
+		m_IsEndOfFile = false;
+		return true;
+	}
+
+	void VideoDemuxer::TrimQueue(PacketQueue& queue, int streamIndex)
+	{
+		const size_t queuedBytes = queue.Size;
+		const size_t queuedPackets = queue.Packets.size();
+
+		// Down to half the cap, so a decoder that stays stuck doesn't have this happen on every packet,
+		// and on to the next keyframe, so its decoder picks up with something it can decode
+		while (queue.Packets.size() > 1 && (queue.Size > MaxQueuedBytes / 2 || !(queue.Packets.front()->flags & AV_PKT_FLAG_KEY)))
+		{
+			AVPacket* dropped = queue.Packets.front();
+			queue.Packets.pop_front();
+			queue.Size -= dropped->size;
+			av_packet_free(&dropped);
+		}
+
+		NZ_CORE_WARN("Stream {0} stopped reading, dropped {1} queued packets ({2} bytes)!", streamIndex,
+			queuedPackets - queue.Packets.size(), queuedBytes - queue.Size);
+	}
+
+	void VideoDemuxer::FlushQueue(PacketQueue& queue)
+	{
+		for (AVPacket* packet : queue.Packets)
+			av_packet_free(&packet);
+
+		queue.Packets.clear();
+		queue.Size = 0;
+	}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+extern "C" {
+	#include <libavformat/avformat.h>
+}
+
+#include "VideoMappedInput.h"
+#include "VideoProbeCache.h"
+
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// The one AVFormatContext of a video, shared by its video and audio decoders.
+	// Whoever needs a packet drives demuxing, packets of the other streams that are being
+	// read are queued for their decoders instead of being read a second time from the file.
+	class VideoDemuxer
+	{
+	public:
+		VideoDemuxer() = default;
+		~VideoDemuxer();
+
+		VideoDemuxer(const VideoDemuxer&) = delete;
+		VideoDemuxer& operator=(const VideoDemuxer&) = delete;
+
+		bool Open(const VideoSource& source);
+		void Close();
+
+		// Local files are read through a memory mapping unless this is turned off.
+		// Videos inside asset packs are always mapped, FFmpeg can't read a byte range on its own.
+		static void SetUseMappedInput(bool useMappedInput) { m_UseMappedInput = useMappedInput; }
+
+		// Reopening a video skips probing its packets if nothing about it changed since it was last opened
+		static void SetUseProbeCache(bool useProbeCache) { m_UseProbeCache = useProbeCache; }
+
+		bool IsOpen() const { return m_FormatContext != nullptr; }
+		AVFormatContext* GetFormatContext() const { return m_FormatContext; }
+
+		// Only streams somebody holds are demuxed, the demuxer closes once the last one is released
+		void AcquireStream(int streamIndex);
+		void ReleaseStream(int streamIndex);
+
+		// Next packet of the stream, or AVERROR_EOF once the file and its queue are both exhausted
+		int ReadPacket(int streamIndex, AVPacket* packet);
+		// Packets read ahead for the stream while another one was being demuxed
+		uint32_t GetQueuedPacketCount(int streamIndex);
+
+		// Moves every stream at once and drops everything queued.
+		// target is where the caller actually wants to be (timestamp may be an earlier keyframe or a byte offset),
+		// the other decoders use it to skip what comes before it.
+		int Seek(int streamIndex, int64_t timestamp, int flags, int64_t target);
+
+		// The serial changes with every seek, so decoders can tell that they need to flush
+		void GetSeekPoint(uint32_t& serial, int64_t& target);
+		uint32_t GetSeekSerial();
+
+		// At the end of the file reading carries on from the start, with timestamps continuing where the pass ended.
+		// The decoders see one endless stream, so the start is decoded while the end is still queued and nothing is flushed.
+		void SetLooping(bool isLooping) { m_IsLooping = isLooping; }
+		bool IsLooping() const { return m_IsLooping; }
+		// Passes completed since the last seek, every one of them adds GetLoopDuration() to the timestamps
+		uint32_t GetLoopCount();
+		// In AV_TIME_BASE units, 0 until the end was reached once
+		int64_t GetLoopDuration();
+
+	private:
+		struct PacketQueue
+		{
+			std::deque<AVPacket*> Packets;
+			size_t Size = 0;
+			uint32_t Holders = 0;
+			// Where the last packet read so far ends, in AV_TIME_BASE units
+			int64_t EndTimestamp = AV_NOPTS_VALUE;
+		};
+
+		void FlushQueue(PacketQueue& queue);
+		// Drops the oldest packets of a queue that went over MaxQueuedBytes
+		void TrimQueue(PacketQueue& queue, int streamIndex);
+		void TrackEndTimestamp(const AVPacket* packet);
+		void AddLoopOffset(AVPacket* packet);
+		bool RewindForLoop();
+
+	private:
+		// Safety net for a decoder that stopped reading while another one keeps going. The other decoder can't be
+		// held back until it catches up, a paused audio stream would stall the video forever, so its packets are dropped.
+		static const size_t MaxQueuedBytes = 64 * 1024 * 1024;
+
+		// Smallest probe FFmpeg accepts, the format is known up front when the cache is used
+		static const int64_t CachedProbeSize = 2048;
+
+		inline static bool m_UseMappedInput = true;
+		inline static bool m_UseProbeCache = true;
+
+		AVFormatContext* m_FormatContext = nullptr;
+		VideoMappedInput m_MappedInput;
+		std::vector<PacketQueue> m_Queues;
+		bool m_IsEndOfFile = false;
+
+		uint32_t m_SeekSerial = 0;
+		// In AV_TIME_BASE units
+		int64_t m_SeekTarget = AV_NOPTS_VALUE;
+
+		std::atomic<bool> m_IsLooping = false;
+		uint32_t m_LoopCount = 0;
+		int64_t m_LoopDuration = 0;
+
+		std::mutex m_Mutex;
+	};
+
+}
@@ -0,0 +1,97 @@
+#include "nzpch.h"
+#include "VideoFrameCache.h"
+
+namespace Nutcrackz {
+
+	VideoFrameCache::~VideoFrameCache()
+	{
+		Shutdown();
+	}
+
+	void VideoFrameCache::Init(size_t frameSize, size_t budget)
+	{
+		Shutdown();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_FrameSize = frameSize;
+		m_Capacity = frameSize ? (uint32_t)std::max<size_t>(1, budget / frameSize) : 0;
+	}
+
+	void VideoFrameCache::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& entry : m_Entries)
+			delete[] entry.Data;
+
+		for (uint8_t* buffer : m_FreeBuffers)
+			delete[] buffer;
+
+		m_Entries.clear();
+		m_Lookup.clear();
+		m_FreeBuffers.clear();
+		m_AllocatedCount = 0;
+		m_FrameSize = 0;
+		m_Capacity = 0;
+	}
+
+	bool VideoFrameCache::Touch(int64_t pts)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Lookup.find(pts);
+		if (it == m_Lookup.end())
+			return false;
+
+		m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+		return true;
+	}
+
+	uint8_t* VideoFrameCache::AcquireBuffer()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_FreeBuffers.empty())
+		{
+			uint8_t* buffer = m_FreeBuffers.back();
+			m_FreeBuffers.pop_back();
+			return buffer;
+		}
+
+		if (m_AllocatedCount < m_Capacity || m_Entries.empty())
+		{
+			m_AllocatedCount++;
+			return new uint8_t[m_FrameSize];
+		}
+
+		Entry evicted = m_Entries.back();
+		m_Entries.pop_back();
+		m_Lookup.erase(evicted.Pts);
+		return evicted.Data;
+	}
+
+	void VideoFrameCache::Insert(int64_t pts, uint8_t* buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Lookup.find(pts);
+		if (it != m_Lookup.end())
+		{
+			// Somebody got there first, keep theirs and recycle ours
+			m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+			m_FreeBuffers.push_back(buffer);
+			return;
+		}
+
+		m_Entries.push_front({ pts, buffer });
+		m_Lookup[pts] = m_Entries.begin();
+	}
+
+	void VideoFrameCache::ReleaseBuffer(uint8_t* buffer)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_FreeBuffers.push_back(buffer);
+	}
+
+}
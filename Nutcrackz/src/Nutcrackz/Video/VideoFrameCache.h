@@ -0,0 +1,71 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// Converted frames keyed by pts, within a fixed byte budget.
+	// Once the budget is used up, the least recently used frame gives its buffer to the next one,
+	// so after the first few frames nothing is allocated anymore.
+	// Lookups come from the render thread and inserts from the scrub thread, so every call locks.
+	class VideoFrameCache
+	{
+	public:
+		VideoFrameCache() = default;
+		~VideoFrameCache();
+
+		VideoFrameCache(const VideoFrameCache&) = delete;
+		VideoFrameCache& operator=(const VideoFrameCache&) = delete;
+
+		void Init(size_t frameSize, size_t budget);
+		void Shutdown();
+
+		// Marks the frame as recently used, returns false if it isn't cached
+		bool Touch(int64_t pts);
+		// Calls reader with the frame while it can't be evicted
+		template<typename Func>
+		bool Read(int64_t pts, const Func& reader)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			auto it = m_Lookup.find(pts);
+			if (it == m_Lookup.end())
+				return false;
+
+			m_Entries.splice(m_Entries.begin(), m_Entries, it->second);
+			reader((const uint8_t*)it->second->Data);
+			return true;
+		}
+
+		// A buffer to convert into, either unused or taken from the least recently used frame.
+		// It has to be handed back through Insert() or ReleaseBuffer().
+		uint8_t* AcquireBuffer();
+		void Insert(int64_t pts, uint8_t* buffer);
+		void ReleaseBuffer(uint8_t* buffer);
+
+		size_t GetFrameSize() const { return m_FrameSize; }
+		uint32_t GetCapacity() const { return m_Capacity; }
+
+	private:
+		struct Entry
+		{
+			int64_t Pts = 0;
+			uint8_t* Data = nullptr;
+		};
+
+		size_t m_FrameSize = 0;
+		uint32_t m_Capacity = 0;
+		uint32_t m_AllocatedCount = 0;
+
+		// Most recently used first
+		std::list<Entry> m_Entries;
+		std::unordered_map<int64_t, std::list<Entry>::iterator> m_Lookup;
+		std::vector<uint8_t*> m_FreeBuffers;
+
+		std::mutex m_Mutex;
+	};
+
+}
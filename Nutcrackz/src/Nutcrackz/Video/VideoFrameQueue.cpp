@@ -0,0 +1,194 @@
+#include "nzpch.h"
+#include "VideoFrameQueue.h"
+
+namespace Nutcrackz {
+
+	VideoFrameQueue::~VideoFrameQueue()
+	{
+		Shutdown();
+	}
+
+	void VideoFrameQueue::Init(uint32_t capacity, size_t frameSize, uint8_t* storage)
+	{
+		Shutdown();
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_FrameSize = frameSize;
+		m_OwnsStorage = storage == nullptr;
+		m_Frames.resize(capacity);
+
+		for (uint32_t i = 0; i < capacity; i++)
+			m_Frames[i].Data = m_OwnsStorage ? new uint8_t[frameSize] : storage + i * frameSize;
+
+		m_ReadIndex = 0;
+		m_Count = 0;
+		m_HasPresented = false;
+		m_IsFinished = false;
+		m_IsAborted = false;
+	}
+
+	void VideoFrameQueue::Shutdown()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& frame : m_Frames)
+		{
+			if (m_OwnsStorage)
+				delete[] frame.Data;
+
+			frame.Data = nullptr;
+		}
+
+		m_Frames.clear();
+		m_FrameSize = 0;
+		m_ReadIndex = 0;
+		m_Count = 0;
+		m_HasPresented = false;
+	}
+
+	DecodedVideoFrame* VideoFrameQueue::BeginPush()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		m_CanWrite.wait(lock, [this]() { return m_Count < m_Frames.size() || m_IsAborted; });
+
+		if (m_IsAborted)
+			return nullptr;
+
+		uint32_t writeIndex = (m_ReadIndex + m_Count) % (uint32_t)m_Frames.size();
+		return &m_Frames[writeIndex];
+	}
+
+	void VideoFrameQueue::EndPush()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Count++;
+		}
+
+		m_CanRead.notify_one();
+	}
+
+	void VideoFrameQueue::Finish()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_IsFinished = true;
+		}
+
+		m_CanRead.notify_all();
+	}
+
+	DecodedVideoFrame* VideoFrameQueue::PresentNext()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		// The frame that is currently on screen still occupies the front slot,
+		// so we need one more queued frame before we can move on
+		const uint32_t required = m_HasPresented ? 2 : 1;
+		m_CanRead.wait(lock, [&]() { return m_Count >= required || m_IsFinished || m_IsAborted; });
+
+		if (m_Count >= required)
+		{
+			if (m_HasPresented)
+			{
+				m_ReadIndex = (m_ReadIndex + 1) % (uint32_t)m_Frames.size();
+				m_Count--;
+				m_CanWrite.notify_one();
+			}
+
+			m_HasPresented = true;
+		}
+
+		return m_HasPresented ? &m_Frames[m_ReadIndex] : nullptr;
+	}
+
+	DecodedVideoFrame* VideoFrameQueue::GetPresented()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_HasPresented ? &m_Frames[m_ReadIndex] : nullptr;
+	}
+
+	DecodedVideoFrame* VideoFrameQueue::PresentDue(int64_t pts, uint32_t& droppedCount, const std::function<void(DecodedVideoFrame*)>& retire)
+	{
+		droppedCount = 0;
+
+		DecodedVideoFrame* presented;
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			const uint32_t capacity = (uint32_t)m_Frames.size();
+			const uint32_t first = m_HasPresented ? 1 : 0;
+
+			// Frames come out of the decoder in presentation order, so the due ones are all at the front
+			uint32_t due = first;
+			while (due < m_Count && m_Frames[(m_ReadIndex + due) % capacity].Pts <= pts)
+				due++;
+
+			// Nothing is on screen yet, the first frame is better than none even if it's early
+			if (!m_HasPresented && due == 0 && m_Count > 0)
+				due = 1;
+
+			if (due == first)
+				return m_HasPresented ? &m_Frames[m_ReadIndex] : nullptr;
+
+			// The producer can't get at the old front slot before we hand it back below
+			if (m_HasPresented && retire)
+				retire(&m_Frames[m_ReadIndex]);
+
+			// due counts the frame to show, first skips the one on screen
+			const uint32_t advance = due - 1;
+			droppedCount = advance - first;
+
+			m_ReadIndex = (m_ReadIndex + advance) % capacity;
+			m_Count -= advance;
+			m_HasPresented = true;
+
+			presented = &m_Frames[m_ReadIndex];
+		}
+
+		m_CanWrite.notify_one();
+		return presented;
+	}
+
+	bool VideoFrameQueue::IsBehind(int64_t pts, int64_t frameDuration)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_HasPresented && m_Count <= 1 && !m_IsFinished && pts >= m_Frames[m_ReadIndex].Pts + frameDuration;
+	}
+
+	void VideoFrameQueue::Flush()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			m_ReadIndex = 0;
+			m_Count = 0;
+			m_HasPresented = false;
+			m_IsFinished = false;
+			m_IsAborted = false;
+		}
+
+		m_CanWrite.notify_all();
+	}
+
+	void VideoFrameQueue::Abort()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_IsAborted = true;
+		}
+
+		m_CanRead.notify_all();
+		m_CanWrite.notify_all();
+	}
+
+	uint32_t VideoFrameQueue::GetCount()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Count;
+	}
+
+}
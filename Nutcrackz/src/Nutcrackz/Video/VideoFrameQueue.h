@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace Nutcrackz {
+
+	struct DecodedVideoFrame
+	{
+		uint8_t* Data = nullptr;
+		int64_t Pts = 0;
+	};
+
+	// Fixed-capacity ring of converted RGBA frames, filled by the decode thread
+	// and drained by the render thread. All frame buffers are allocated once in Init()
+	// (or handed in as mapped pixel buffer memory), so the producer converts straight
+	// into a slot and nothing is allocated per frame.
+	class VideoFrameQueue
+	{
+	public:
+		VideoFrameQueue() = default;
+		~VideoFrameQueue();
+
+		void Init(uint32_t capacity, size_t frameSize, uint8_t* storage = nullptr);
+		void Shutdown();
+
+		// Producer side
+		DecodedVideoFrame* BeginPush();
+		void EndPush();
+		void Finish();
+
+		// Consumer side
+		DecodedVideoFrame* PresentNext();
+		DecodedVideoFrame* GetPresented();
+
+		// Never waits for the producer. Moves to the newest queued frame that is due at pts, every frame skipped on the way is dropped.
+		// Returns the frame on screen afterwards, which stays the same one while nothing new is due.
+		// retire is called with the frame being replaced before its slot can be written again.
+		DecodedVideoFrame* PresentDue(int64_t pts, uint32_t& droppedCount, const std::function<void(DecodedVideoFrame*)>& retire);
+		// The frame after the one on screen should be showing by pts but hasn't been decoded yet
+		bool IsBehind(int64_t pts, int64_t frameDuration);
+
+		void Flush();
+		void Abort();
+
+		uint32_t GetCount();
+		uint32_t GetCapacity() const { return (uint32_t)m_Frames.size(); }
+		size_t GetFrameSize() const { return m_FrameSize; }
+
+	private:
+		std::vector<DecodedVideoFrame> m_Frames;
+		size_t m_FrameSize = 0;
+		bool m_OwnsStorage = true;
+
+		uint32_t m_ReadIndex = 0;
+		uint32_t m_Count = 0;
+
+		// The front frame stays owned by the render thread until the next one replaces it,
+		// so a paused video can keep showing it without holding a copy.
+		bool m_HasPresented = false;
+		bool m_IsFinished = false;
+		bool m_IsAborted = false;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_CanRead;
+		std::condition_variable m_CanWrite;
+	};
+
+}
@@ -0,0 +1,244 @@
+#include "nzpch.h"
+#include "VideoMappedInput.h"
+
+extern "C" {
+	#include <libavutil/mem.h>
+}
+
+#ifdef _WIN32
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Nutcrackz {
+
+	namespace Utils {
+
+		static size_t GetPageSize()
+		{
+#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return (size_t)info.dwPageSize;
+#else
+			return (size_t)sysconf(_SC_PAGESIZE);
+#endif
+		}
+
+		static size_t GetAllocationGranularity()
+		{
+#ifdef _WIN32
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return (size_t)info.dwAllocationGranularity;
+#else
+			return GetPageSize();
+#endif
+		}
+
+		// Works out which part of the file to map, viewOffset is rounded down to where a view may start
+		static bool GetMappedRange(const VideoSource& source, uint64_t fileSize, uint64_t& viewOffset, size_t& viewSize, size_t& size)
+		{
+			if (source.Offset >= fileSize)
+				return false;
+
+			const uint64_t rangeSize = source.Size ? source.Size : fileSize - source.Offset;
+			if (rangeSize == 0 || rangeSize > fileSize - source.Offset)
+				return false;
+
+			viewOffset = source.Offset - source.Offset % GetAllocationGranularity();
+			viewSize = (size_t)(source.Offset + rangeSize - viewOffset);
+			size = (size_t)rangeSize;
+			return true;
+		}
+
+		static const uint8_t* MapFile(const VideoSource& source, size_t& viewSize, size_t& size)
+		{
+			uint64_t viewOffset;
+
+#ifdef _WIN32
+			HANDLE file = CreateFileW(source.Path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+				return nullptr;
+
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize) || !GetMappedRange(source, (uint64_t)fileSize.QuadPart, viewOffset, viewSize, size))
+			{
+				CloseHandle(file);
+				return nullptr;
+			}
+
+			HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			CloseHandle(file);
+
+			if (!mapping)
+				return nullptr;
+
+			// The view keeps the mapping alive on its own
+			void* data = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(viewOffset >> 32), (DWORD)(viewOffset & 0xFFFFFFFF), viewSize);
+			CloseHandle(mapping);
+
+			return (const uint8_t*)data;
+#else
+			int file = open(source.Path.c_str(), O_RDONLY);
+			if (file < 0)
+				return nullptr;
+
+			struct stat info;
+			if (fstat(file, &info) != 0 || !GetMappedRange(source, (uint64_t)info.st_size, viewOffset, viewSize, size))
+			{
+				close(file);
+				return nullptr;
+			}
+
+			void* data = mmap(nullptr, viewSize, PROT_READ, MAP_PRIVATE, file, (off_t)viewOffset);
+			close(file);
+
+			if (data == MAP_FAILED)
+				return nullptr;
+
+			// Demuxing mostly reads front to back, seeks are handled by prefetching around the new position
+			madvise(data, viewSize, MADV_SEQUENTIAL);
+
+			return (const uint8_t*)data;
+#endif
+		}
+
+		static void UnmapFile(const uint8_t* data, size_t size)
+		{
+#ifdef _WIN32
+			UnmapViewOfFile(data);
+#else
+			munmap((void*)data, size);
+#endif
+		}
+
+		static void PrefetchRange(const uint8_t* data, size_t size)
+		{
+#ifdef _WIN32
+			WIN32_MEMORY_RANGE_ENTRY range = { (void*)data, size };
+			PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+			madvise((void*)data, size, MADV_WILLNEED);
+#endif
+		}
+
+	}
+
+	VideoMappedInput::~VideoMappedInput()
+	{
+		Close();
+	}
+
+	bool VideoMappedInput::Open(const VideoSource& source)
+	{
+		Close();
+
+		m_View = Utils::MapFile(source, m_ViewSize, m_Size);
+		if (!m_View)
+			return false;
+
+		// The range ends where the view ends, so it starts this far into it
+		m_Data = m_View + (m_ViewSize - m_Size);
+
+		uint8_t* buffer = (uint8_t*)av_malloc(IOBufferSize);
+		m_IOContext = buffer ? avio_alloc_context(buffer, IOBufferSize, 0, this, &VideoMappedInput::Read, nullptr, &VideoMappedInput::Seek) : nullptr;
+
+		if (!m_IOContext)
+		{
+			av_free(buffer);
+			Close();
+			return false;
+		}
+
+		m_Position = 0;
+		m_PrefetchStart = m_PrefetchEnd = 0;
+		Prefetch(0);
+
+		return true;
+	}
+
+	void VideoMappedInput::Close()
+	{
+		if (m_IOContext)
+		{
+			av_freep(&m_IOContext->buffer);
+			avio_context_free(&m_IOContext);
+		}
+
+		if (m_View)
+			Utils::UnmapFile(m_View, m_ViewSize);
+
+		m_View = nullptr;
+		m_ViewSize = 0;
+		m_Data = nullptr;
+		m_Size = 0;
+		m_Position = 0;
+	}
+
+	int VideoMappedInput::Read(void* opaque, uint8_t* buffer, int size)
+	{
+		VideoMappedInput* input = (VideoMappedInput*)opaque;
+
+		if (input->m_Position >= input->m_Size)
+			return AVERROR_EOF;
+
+		const size_t count = std::min((size_t)size, input->m_Size - input->m_Position);
+		memcpy(buffer, input->m_Data + input->m_Position, count);
+
+		input->m_Position += count;
+		input->Prefetch(input->m_Position);
+
+		return (int)count;
+	}
+
+	int64_t VideoMappedInput::Seek(void* opaque, int64_t offset, int whence)
+	{
+		VideoMappedInput* input = (VideoMappedInput*)opaque;
+		int64_t position;
+
+		switch (whence & ~AVSEEK_FORCE)
+		{
+			case AVSEEK_SIZE: return (int64_t)input->m_Size;
+			case SEEK_SET: position = offset; break;
+			case SEEK_CUR: position = (int64_t)input->m_Position + offset; break;
+			case SEEK_END: position = (int64_t)input->m_Size + offset; break;
+			default: return AVERROR(EINVAL);
+		}
+
+		if (position < 0 || position > (int64_t)input->m_Size)
+			return AVERROR(EINVAL);
+
+		input->m_Position = (size_t)position;
+		input->Prefetch(input->m_Position);
+
+		return position;
+	}
+
+	void VideoMappedInput::Prefetch(size_t position)
+	{
+		// Only ask again once the read head is halfway through the window we asked for last time
+		if (position >= m_PrefetchStart && (position + PrefetchSize / 2 < m_PrefetchEnd || m_PrefetchEnd == m_Size))
+			return;
+
+		static const size_t pageSize = Utils::GetPageSize();
+
+		if (position >= m_Size)
+			return;
+
+		// Advice has to start on a page, which may be before the range in a packed file but is always inside the view
+		const size_t address = (size_t)(m_Data - m_View) + position;
+		const size_t start = address - address % pageSize;
+		const size_t end = (size_t)(m_Data - m_View) + std::min(position + PrefetchSize, m_Size);
+
+		Utils::PrefetchRange(m_View + start, end - start);
+
+		m_PrefetchStart = position;
+		m_PrefetchEnd = std::min(position + PrefetchSize, m_Size);
+	}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+extern "C" {
+	#include <libavformat/avio.h>
+}
+
+#include "VideoSource.h"
+
+namespace Nutcrackz {
+
+	// Custom AVIOContext that serves reads and seeks straight out of a memory mapped file,
+	// instead of going through FFmpeg's file protocol and a read call per small buffer.
+	// The OS is asked to read ahead of wherever FFmpeg is reading.
+	// Only the source's byte range is mapped, FFmpeg sees it as a file of its own.
+	class VideoMappedInput
+	{
+	public:
+		VideoMappedInput() = default;
+		~VideoMappedInput();
+
+		VideoMappedInput(const VideoMappedInput&) = delete;
+		VideoMappedInput& operator=(const VideoMappedInput&) = delete;
+
+		bool Open(const VideoSource& source);
+		void Close();
+
+		bool IsOpen() const { return m_IOContext != nullptr; }
+		AVIOContext* GetIOContext() const { return m_IOContext; }
+
+	private:
+		static int Read(void* opaque, uint8_t* buffer, int size);
+		static int64_t Seek(void* opaque, int64_t offset, int whence);
+
+		void Prefetch(size_t position);
+
+	private:
+		// Reads bigger than the AVIOContext's own buffer are copied straight into the caller's memory,
+		// so keeping it small means large packets are copied exactly once, out of the mapping
+		static const int IOBufferSize = 32 * 1024;
+		static const size_t PrefetchSize = 8 * 1024 * 1024;
+
+		// Views have to start on an allocation boundary, the range itself starts m_Data - m_View into it
+		const uint8_t* m_View = nullptr;
+		size_t m_ViewSize = 0;
+
+		const uint8_t* m_Data = nullptr;
+		size_t m_Size = 0;
+		size_t m_Position = 0;
+
+		size_t m_PrefetchStart = 0;
+		size_t m_PrefetchEnd = 0;
+
+		AVIOContext* m_IOContext = nullptr;
+	};
+
+}
@@ -0,0 +1,200 @@
+#include "nzpch.h"
+#include "VideoPixelBufferRing.h"
+
+#include <glad/glad.h>
+
+namespace Nutcrackz {
+
+	VideoPixelBufferRing::~VideoPixelBufferRing()
+	{
+		Shutdown();
+	}
+
+	VideoUploadMode VideoPixelBufferRing::Init(const std::vector<VideoTexturePlane>& planes, uint32_t count, VideoUploadMode mode)
+	{
+		Shutdown();
+
+		m_Planes = planes;
+		m_FrameSize = 0;
+
+		for (const auto& plane : m_Planes)
+			m_FrameSize = std::max(m_FrameSize, plane.Offset + plane.GetSize());
+		m_Count = count;
+		m_NextSlot = 0;
+		m_Mode = mode;
+
+		if (m_Mode == VideoUploadMode::PersistentPixelBuffer && !InitPersistent())
+		{
+			NZ_CORE_WARN("Persistently mapped pixel buffers are not available, falling back to mapped pixel buffers.");
+			Shutdown();
+			m_Mode = VideoUploadMode::PixelBuffer;
+		}
+
+		if (m_Mode == VideoUploadMode::PixelBuffer && !InitPixelBuffers())
+		{
+			NZ_CORE_WARN("Pixel buffers are not available, falling back to direct texture uploads.");
+			Shutdown();
+			m_Mode = VideoUploadMode::Direct;
+		}
+
+		return m_Mode;
+	}
+
+	bool VideoPixelBufferRing::InitPersistent()
+	{
+		if (!GLAD_GL_VERSION_4_4 && !GLAD_GL_ARB_buffer_storage)
+			return false;
+
+		m_Buffers.resize(1);
+		m_Fences.resize(m_Count, nullptr);
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr size = (GLsizeiptr)(m_FrameSize * m_Count);
+
+		glCreateBuffers(1, &m_Buffers[0]);
+		glNamedBufferStorage(m_Buffers[0], size, nullptr, flags);
+		m_PersistentStorage = (uint8_t*)glMapNamedBufferRange(m_Buffers[0], 0, size, flags);
+
+		return m_PersistentStorage != nullptr;
+	}
+
+	bool VideoPixelBufferRing::InitPixelBuffers()
+	{
+		m_Buffers.resize(m_Count);
+		m_Fences.resize(m_Count, nullptr);
+
+		glCreateBuffers(m_Count, m_Buffers.data());
+
+		for (uint32_t buffer : m_Buffers)
+		{
+			if (!buffer)
+				return false;
+
+			glNamedBufferData(buffer, (GLsizeiptr)m_FrameSize, nullptr, GL_STREAM_DRAW);
+		}
+
+		return glGetError() == GL_NO_ERROR;
+	}
+
+	void VideoPixelBufferRing::Shutdown()
+	{
+		WaitForAll();
+
+		if (m_PersistentStorage)
+		{
+			glUnmapNamedBuffer(m_Buffers[0]);
+			m_PersistentStorage = nullptr;
+		}
+
+		if (!m_Buffers.empty())
+			glDeleteBuffers((GLsizei)m_Buffers.size(), m_Buffers.data());
+
+		m_Buffers.clear();
+		m_Fences.clear();
+		m_Count = 0;
+	}
+
+	void VideoPixelBufferRing::Upload(const uint32_t* textureIDs, const uint8_t* frameData)
+	{
+		switch (m_Mode)
+		{
+			case VideoUploadMode::Direct:
+			{
+				UploadPlanes(textureIDs, (uintptr_t)frameData);
+				return;
+			}
+			case VideoUploadMode::PixelBuffer:
+			{
+				const uint32_t slot = m_NextSlot;
+				m_NextSlot = (m_NextSlot + 1) % m_Count;
+
+				// This buffer was last used `count` frames ago, so the wait is almost always free
+				WaitForSlot(slot);
+
+				void* mapped = glMapNamedBufferRange(m_Buffers[slot], 0, (GLsizeiptr)m_FrameSize,
+					GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+				if (!mapped)
+				{
+					UploadPlanes(textureIDs, (uintptr_t)frameData);
+					return;
+				}
+
+				memcpy(mapped, frameData, m_FrameSize);
+				glUnmapNamedBuffer(m_Buffers[slot]);
+
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffers[slot]);
+				UploadPlanes(textureIDs, 0);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+				m_Fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				return;
+			}
+			case VideoUploadMode::PersistentPixelBuffer:
+			{
+				// The frame was decoded straight into our mapping, so all that's left is to point GL at it
+				const size_t offset = (size_t)(frameData - m_PersistentStorage);
+				const uint32_t slot = (uint32_t)(offset / m_FrameSize);
+
+				NZ_CORE_ASSERT(slot < m_Count, "Frame data does not belong to this pixel buffer ring!");
+
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_Buffers[0]);
+				UploadPlanes(textureIDs, offset);
+				glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+				WaitForSlot(slot);
+				m_Fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				return;
+			}
+		}
+	}
+
+	void VideoPixelBufferRing::UploadPlanes(const uint32_t* textureIDs, uintptr_t base)
+	{
+		// Chroma planes of odd sized videos don't have 4 byte aligned rows
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (size_t i = 0; i < m_Planes.size(); i++)
+		{
+			const VideoTexturePlane& plane = m_Planes[i];
+			const GLenum format = plane.Channels == 4 ? GL_RGBA : GL_RED;
+
+			glTextureSubImage2D(textureIDs[i], 0, 0, 0, plane.Width, plane.Height, format, GL_UNSIGNED_BYTE, (const void*)(base + plane.Offset));
+		}
+
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	void VideoPixelBufferRing::Release(const uint8_t* frameData)
+	{
+		if (m_Mode != VideoUploadMode::PersistentPixelBuffer || !frameData)
+			return;
+
+		WaitForSlot((uint32_t)((size_t)(frameData - m_PersistentStorage) / m_FrameSize));
+	}
+
+	void VideoPixelBufferRing::WaitForAll()
+	{
+		for (uint32_t i = 0; i < (uint32_t)m_Fences.size(); i++)
+			WaitForSlot(i);
+	}
+
+	void VideoPixelBufferRing::WaitForSlot(uint32_t slot)
+	{
+		GLsync fence = (GLsync)m_Fences[slot];
+
+		if (!fence)
+			return;
+
+		while (true)
+		{
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+				break;
+		}
+
+		glDeleteSync(fence);
+		m_Fences[slot] = nullptr;
+	}
+
+}
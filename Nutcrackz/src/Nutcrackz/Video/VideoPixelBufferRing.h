@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+
+namespace Nutcrackz {
+
+	enum class VideoUploadMode
+	{
+		// Plain glTextureSubImage2D from client memory, works on any (including software) GL implementation
+		Direct = 0,
+		// Round-robin pixel unpack buffers that are mapped and filled once per frame
+		PixelBuffer,
+		// One persistently mapped pixel unpack buffer that the decode thread converts into directly
+		PersistentPixelBuffer
+	};
+
+	// One texture worth of a frame, frames are stored as their planes back to back
+	struct VideoTexturePlane
+	{
+		uint32_t Width = 0, Height = 0;
+		uint32_t Channels = 4;
+		size_t Offset = 0;
+
+		size_t GetSize() const { return (size_t)Width * Height * Channels; }
+	};
+
+	// Streams frames into immutable textures (one per plane) through a small ring of pixel unpack buffers,
+	// so uploads are queued on the GPU instead of stalling the render thread.
+	class VideoPixelBufferRing
+	{
+	public:
+		VideoPixelBufferRing() = default;
+		~VideoPixelBufferRing();
+
+		VideoUploadMode Init(const std::vector<VideoTexturePlane>& planes, uint32_t count, VideoUploadMode mode);
+		void Shutdown();
+
+		void Upload(const uint32_t* textureIDs, const uint8_t* frameData);
+		// Uploads from client memory that doesn't belong to the ring, whatever the mode is
+		void UploadDirect(const uint32_t* textureIDs, const uint8_t* frameData) { UploadPlanes(textureIDs, (uintptr_t)frameData); }
+
+		// Blocks until the GPU is done reading the slot that holds frameData, so it can be rewritten
+		void Release(const uint8_t* frameData);
+		void WaitForAll();
+
+		// Only valid in PersistentPixelBuffer mode, holds `count` frames back to back
+		uint8_t* GetPersistentStorage() const { return m_PersistentStorage; }
+		VideoUploadMode GetMode() const { return m_Mode; }
+		size_t GetFrameSize() const { return m_FrameSize; }
+
+	private:
+		bool InitPersistent();
+		bool InitPixelBuffers();
+		// base is either a client memory address or an offset into the bound unpack buffer
+		void UploadPlanes(const uint32_t* textureIDs, uintptr_t base);
+		void WaitForSlot(uint32_t slot);
+
+	private:
+		VideoUploadMode m_Mode = VideoUploadMode::Direct;
+		std::vector<VideoTexturePlane> m_Planes;
+		size_t m_FrameSize = 0;
+		uint32_t m_Count = 0;
+		uint32_t m_NextSlot = 0;
+
+		std::vector<uint32_t> m_Buffers;
+		std::vector<void*> m_Fences;
+		uint8_t* m_PersistentStorage = nullptr;
+	};
+
+}
@@ -0,0 +1,201 @@
+#include "nzpch.h"
+#include "VideoProbeCache.h"
+
+#include <fstream>
+
+namespace Nutcrackz {
+
+	namespace Utils {
+
+		// FNV-1a
+		static uint64_t HashBytes(const char* data, size_t size, uint64_t hash)
+		{
+			for (size_t i = 0; i < size; i++)
+			{
+				hash ^= (uint8_t)data[i];
+				hash *= 0x100000001B3ull;
+			}
+
+			return hash;
+		}
+
+		static bool HashRange(std::ifstream& stream, uint64_t offset, size_t size, std::vector<char>& buffer, uint64_t& hash)
+		{
+			buffer.resize(size);
+
+			if (!stream.seekg((std::streamoff)offset) || !stream.read(buffer.data(), (std::streamsize)size))
+				return false;
+
+			hash = HashBytes(buffer.data(), size, hash);
+			return true;
+		}
+
+	}
+
+	bool VideoProbeCache::GetKey(const VideoSource& source, VideoProbeKey& key)
+	{
+		std::error_code error;
+
+		key.FileSize = (uint64_t)std::filesystem::file_size(source.Path, error);
+		if (error || source.Offset >= key.FileSize)
+			return false;
+
+		key.WriteTime = (int64_t)std::filesystem::last_write_time(source.Path, error).time_since_epoch().count();
+		if (error)
+			return false;
+
+		key.Name = source.Path.string();
+		if (source.IsPacked())
+			key.Name += "@" + std::to_string(source.Offset) + ":" + std::to_string(source.Size);
+
+		const uint64_t size = source.Size ? std::min(source.Size, key.FileSize - source.Offset) : key.FileSize - source.Offset;
+
+		std::ifstream stream(source.Path, std::ios::binary);
+		if (!stream)
+			return false;
+
+		std::vector<char> buffer;
+		key.Hash = 0xCBF29CE484222325ull;
+
+		const size_t headSize = (size_t)std::min<uint64_t>(HashedBytes, size);
+		if (!Utils::HashRange(stream, source.Offset, headSize, buffer, key.Hash))
+			return false;
+
+		if (size > HashedBytes)
+		{
+			const size_t tailSize = (size_t)std::min<uint64_t>(HashedBytes, size - HashedBytes);
+			if (!Utils::HashRange(stream, source.Offset + size - tailSize, tailSize, buffer, key.Hash))
+				return false;
+		}
+
+		return true;
+	}
+
+	const AVInputFormat* VideoProbeCache::FindFormat(const VideoProbeKey& key)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Entries.find(key.Name);
+		if (it == m_Entries.end())
+			return nullptr;
+
+		const VideoProbeKey& cachedKey = it->second.Key;
+		if (cachedKey.FileSize != key.FileSize || cachedKey.WriteTime != key.WriteTime || cachedKey.Hash != key.Hash)
+		{
+			// The video changed, it will be probed and stored again
+			FreeEntry(it->second);
+			m_Entries.erase(it);
+			return nullptr;
+		}
+
+		return it->second.Format;
+	}
+
+	bool VideoProbeCache::Apply(const VideoProbeKey& key, AVFormatContext* formatContext)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Entries.find(key.Name);
+		if (it == m_Entries.end())
+			return false;
+
+		const Entry& entry = it->second;
+		if (entry.Key.Hash != key.Hash || entry.Streams.size() != formatContext->nb_streams)
+			return false;
+
+		for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+		{
+			const AVCodecParameters* cached = entry.Streams[i].CodecParameters;
+			const AVCodecParameters* parsed = formatContext->streams[i]->codecpar;
+
+			if (parsed->codec_type != cached->codec_type || (parsed->codec_id != AV_CODEC_ID_NONE && parsed->codec_id != cached->codec_id))
+				return false;
+		}
+
+		for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+		{
+			const StreamInfo& info = entry.Streams[i];
+			AVStream* stream = formatContext->streams[i];
+
+			if (avcodec_parameters_copy(stream->codecpar, info.CodecParameters) < 0)
+				return false;
+
+			stream->time_base = info.TimeBase;
+			stream->r_frame_rate = info.FrameRate;
+			stream->avg_frame_rate = info.AverageFrameRate;
+			stream->start_time = info.StartTime;
+			stream->duration = info.Duration;
+			stream->nb_frames = info.FrameCount;
+		}
+
+		formatContext->start_time = entry.StartTime;
+		formatContext->duration = entry.Duration;
+		formatContext->bit_rate = entry.BitRate;
+
+		return true;
+	}
+
+	void VideoProbeCache::Store(const VideoProbeKey& key, const AVFormatContext* formatContext)
+	{
+		Entry entry;
+		entry.Key = key;
+		entry.Format = formatContext->iformat;
+		entry.StartTime = formatContext->start_time;
+		entry.Duration = formatContext->duration;
+		entry.BitRate = formatContext->bit_rate;
+
+		for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+		{
+			const AVStream* stream = formatContext->streams[i];
+
+			StreamInfo info;
+			info.CodecParameters = avcodec_parameters_alloc();
+
+			if (!info.CodecParameters || avcodec_parameters_copy(info.CodecParameters, stream->codecpar) < 0)
+			{
+				avcodec_parameters_free(&info.CodecParameters);
+				FreeEntry(entry);
+				return;
+			}
+
+			info.TimeBase = stream->time_base;
+			info.FrameRate = stream->r_frame_rate;
+			info.AverageFrameRate = stream->avg_frame_rate;
+			info.StartTime = stream->start_time;
+			info.Duration = stream->duration;
+			info.FrameCount = stream->nb_frames;
+			entry.Streams.push_back(info);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		auto it = m_Entries.find(key.Name);
+		if (it != m_Entries.end())
+		{
+			FreeEntry(it->second);
+			it->second = std::move(entry);
+			return;
+		}
+
+		m_Entries.emplace(key.Name, std::move(entry));
+	}
+
+	void VideoProbeCache::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		for (auto& [name, entry] : m_Entries)
+			FreeEntry(entry);
+
+		m_Entries.clear();
+	}
+
+	void VideoProbeCache::FreeEntry(Entry& entry)
+	{
+		for (auto& info : entry.Streams)
+			avcodec_parameters_free(&info.CodecParameters);
+
+		entry.Streams.clear();
+	}
+
+}
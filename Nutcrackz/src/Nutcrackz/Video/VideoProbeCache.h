@@ -0,0 +1,75 @@
+#pragma once
+
+extern "C" {
+	#include <libavformat/avformat.h>
+}
+
+#include "VideoSource.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// Identifies one version of a video's bytes. Size and write time catch most edits,
+	// the hash of the start and end of the video catches the rest (that's where containers keep their headers).
+	struct VideoProbeKey
+	{
+		std::string Name;
+		uint64_t FileSize = 0;
+		int64_t WriteTime = 0;
+		uint64_t Hash = 0;
+	};
+
+	// Remembers what avformat_find_stream_info() found out about every video opened so far,
+	// so reopening one only has to read its header instead of probing its packets again
+	class VideoProbeCache
+	{
+	public:
+		static bool GetKey(const VideoSource& source, VideoProbeKey& key);
+
+		// Format to open the video with, nullptr if it isn't cached
+		static const AVInputFormat* FindFormat(const VideoProbeKey& key);
+
+		// Fills in the streams of a context that was opened without probing.
+		// Fails if the header didn't produce the streams that were cached, the caller has to probe then.
+		static bool Apply(const VideoProbeKey& key, AVFormatContext* formatContext);
+		static void Store(const VideoProbeKey& key, const AVFormatContext* formatContext);
+
+		static void Clear();
+
+	private:
+		struct StreamInfo
+		{
+			AVCodecParameters* CodecParameters = nullptr;
+			AVRational TimeBase;
+			AVRational FrameRate;
+			AVRational AverageFrameRate;
+			int64_t StartTime;
+			int64_t Duration;
+			int64_t FrameCount;
+		};
+
+		struct Entry
+		{
+			VideoProbeKey Key;
+			const AVInputFormat* Format = nullptr;
+			int64_t StartTime;
+			int64_t Duration;
+			int64_t BitRate;
+			std::vector<StreamInfo> Streams;
+		};
+
+		static void FreeEntry(Entry& entry);
+
+	private:
+		// Only the start and end of the video are hashed, it has to stay a lot cheaper than probing
+		static const size_t HashedBytes = 64 * 1024;
+
+		inline static std::unordered_map<std::string, Entry> m_Entries;
+		inline static std::mutex m_Mutex;
+	};
+
+}
@@ -0,0 +1,249 @@
+#include "nzpch.h"
+#include "VideoSeekIndex.h"
+
+#include "VideoDemuxer.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace Nutcrackz {
+
+	// Bump whenever the sidecar layout changes, older files are rebuilt
+	static const uint32_t s_SeekIndexMagic = 0x58495A4E; // "NZIX"
+	static const uint32_t s_SeekIndexVersion = 1;
+
+	namespace Utils {
+
+		struct SeekIndexHeader
+		{
+			uint32_t Magic;
+			uint32_t Version;
+			uint64_t VideoSize;
+			int64_t VideoWriteTime;
+			int32_t StreamIndex;
+			uint32_t FrameCount;
+			uint32_t KeyframeCount;
+		};
+
+		static bool GetVideoFileInfo(const std::filesystem::path& videoPath, uint64_t& size, int64_t& writeTime)
+		{
+			std::error_code error;
+
+			size = (uint64_t)std::filesystem::file_size(videoPath, error);
+			if (error)
+				return false;
+
+			writeTime = (int64_t)std::filesystem::last_write_time(videoPath, error).time_since_epoch().count();
+			return !error;
+		}
+
+	}
+
+	VideoSeekIndex::~VideoSeekIndex()
+	{
+		m_IsAborted = true;
+		Wait();
+	}
+
+	bool VideoSeekIndex::Build(AVFormatContext* formatContext, int streamIndex)
+	{
+		m_IsReady = false;
+		m_StreamIndex = streamIndex;
+		m_FramePts.clear();
+		m_Keyframes.clear();
+
+		// Let the demuxer drop every other stream's packets on its own
+		std::vector<AVDiscard> discard(formatContext->nb_streams);
+		for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+		{
+			discard[i] = formatContext->streams[i]->discard;
+			formatContext->streams[i]->discard = (int)i == streamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+		}
+
+		AVPacket* packet = av_packet_alloc();
+
+		while (packet && !m_IsAborted && av_read_frame(formatContext, packet) >= 0)
+		{
+			if (packet->stream_index == streamIndex)
+			{
+				const int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+
+				if (pts != AV_NOPTS_VALUE)
+				{
+					m_FramePts.push_back(pts);
+
+					if (packet->flags & AV_PKT_FLAG_KEY)
+						m_Keyframes.push_back({ pts, packet->pos, 0 });
+				}
+			}
+
+			av_packet_unref(packet);
+		}
+
+		av_packet_free(&packet);
+
+		for (unsigned int i = 0; i < formatContext->nb_streams; i++)
+			formatContext->streams[i]->discard = discard[i];
+
+		// Packets come in decode order, seeking is done in presentation order
+		std::sort(m_FramePts.begin(), m_FramePts.end());
+		std::sort(m_Keyframes.begin(), m_Keyframes.end(), [](const VideoKeyframe& a, const VideoKeyframe& b) { return a.Pts < b.Pts; });
+
+		for (auto& keyframe : m_Keyframes)
+			keyframe.FrameIndex = FindFrameIndex(keyframe.Pts);
+
+		const int64_t start = m_FramePts.empty() ? 0 : m_FramePts.front();
+		if (av_seek_frame(formatContext, streamIndex, start, AVSEEK_FLAG_BACKWARD) < 0)
+			av_seek_frame(formatContext, streamIndex, 0, AVSEEK_FLAG_BYTE);
+
+		// An aborted scan only saw part of the file
+		if (m_IsAborted || m_Keyframes.empty())
+			return false;
+
+		m_IsReady.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void VideoSeekIndex::BuildAsync(const VideoSource& source, int streamIndex)
+	{
+		Wait();
+
+		m_IsAborted = false;
+		m_BuildThread = std::thread(&VideoSeekIndex::BuildThread, this, source, streamIndex);
+	}
+
+	void VideoSeekIndex::Wait()
+	{
+		if (m_BuildThread.joinable())
+			m_BuildThread.join();
+	}
+
+	void VideoSeekIndex::BuildThread(VideoSource source, int streamIndex)
+	{
+		// A packed video is checked against its pack, rebuilding the pack invalidates its sidecars
+		const std::filesystem::path sidecarPath = GetSidecarPath(source);
+		if (Load(sidecarPath, source.Path, streamIndex))
+			return;
+
+		// The caller's demuxer is already feeding its decoders, scanning through it would move it under them
+		VideoDemuxer demuxer;
+		if (!demuxer.Open(source))
+			return;
+
+		if (Build(demuxer.GetFormatContext(), streamIndex) && !Save(sidecarPath, source.Path))
+			NZ_CORE_WARN("Could not write seek index: {0}", sidecarPath.string());
+	}
+
+	bool VideoSeekIndex::Load(const std::filesystem::path& sidecarPath, const std::filesystem::path& videoPath, int streamIndex)
+	{
+		std::ifstream stream(sidecarPath, std::ios::binary);
+		if (!stream)
+			return false;
+
+		Utils::SeekIndexHeader header;
+		if (!stream.read((char*)&header, sizeof(header)))
+			return false;
+
+		uint64_t videoSize;
+		int64_t videoWriteTime;
+		if (!Utils::GetVideoFileInfo(videoPath, videoSize, videoWriteTime))
+			return false;
+
+		if (header.Magic != s_SeekIndexMagic || header.Version != s_SeekIndexVersion || header.StreamIndex != streamIndex
+			|| header.VideoSize != videoSize || header.VideoWriteTime != videoWriteTime)
+			return false;
+
+		// The counts come from the file, a truncated or corrupt sidecar must not make us allocate whatever they say
+		std::error_code error;
+		const uint64_t sidecarSize = std::filesystem::file_size(sidecarPath, error);
+		const uint64_t tableSize = (uint64_t)header.FrameCount * sizeof(int64_t) + (uint64_t)header.KeyframeCount * sizeof(VideoKeyframe);
+
+		if (error || sidecarSize != sizeof(header) + tableSize)
+			return false;
+
+		m_IsReady = false;
+		m_StreamIndex = streamIndex;
+		m_FramePts.resize(header.FrameCount);
+		m_Keyframes.resize(header.KeyframeCount);
+
+		stream.read((char*)m_FramePts.data(), m_FramePts.size() * sizeof(int64_t));
+		stream.read((char*)m_Keyframes.data(), m_Keyframes.size() * sizeof(VideoKeyframe));
+
+		if (!stream || m_Keyframes.empty())
+		{
+			m_FramePts.clear();
+			m_Keyframes.clear();
+			return false;
+		}
+
+		m_IsReady.store(true, std::memory_order_release);
+		return true;
+	}
+
+	bool VideoSeekIndex::Save(const std::filesystem::path& sidecarPath, const std::filesystem::path& videoPath) const
+	{
+		Utils::SeekIndexHeader header = {};
+		header.Magic = s_SeekIndexMagic;
+		header.Version = s_SeekIndexVersion;
+		header.StreamIndex = m_StreamIndex;
+		header.FrameCount = (uint32_t)m_FramePts.size();
+		header.KeyframeCount = (uint32_t)m_Keyframes.size();
+
+		if (!Utils::GetVideoFileInfo(videoPath, header.VideoSize, header.VideoWriteTime))
+			return false;
+
+		std::ofstream stream(sidecarPath, std::ios::binary | std::ios::trunc);
+		if (!stream)
+			return false;
+
+		stream.write((const char*)&header, sizeof(header));
+		stream.write((const char*)m_FramePts.data(), m_FramePts.size() * sizeof(int64_t));
+		stream.write((const char*)m_Keyframes.data(), m_Keyframes.size() * sizeof(VideoKeyframe));
+
+		return (bool)stream;
+	}
+
+	std::filesystem::path VideoSeekIndex::GetSidecarPath(const VideoSource& source)
+	{
+		std::filesystem::path sidecarPath = source.Path;
+		if (source.IsPacked())
+			sidecarPath += "." + std::to_string(source.Offset);
+
+		sidecarPath += ".nzidx";
+		return sidecarPath;
+	}
+
+	const VideoKeyframe* VideoSeekIndex::FindKeyframe(int64_t pts) const
+	{
+		if (IsEmpty())
+			return nullptr;
+
+		auto it = std::upper_bound(m_Keyframes.begin(), m_Keyframes.end(), pts, [](int64_t value, const VideoKeyframe& keyframe) { return value < keyframe.Pts; });
+
+		// Anything before the first keyframe can only be reached from the first keyframe
+		if (it == m_Keyframes.begin())
+			return &m_Keyframes.front();
+
+		return &*(it - 1);
+	}
+
+	uint32_t VideoSeekIndex::FindFrame(int64_t pts) const
+	{
+		return IsReady() ? FindFrameIndex(pts) : 0;
+	}
+
+	uint32_t VideoSeekIndex::FindFrameIndex(int64_t pts) const
+	{
+		auto it = std::upper_bound(m_FramePts.begin(), m_FramePts.end(), pts);
+		return it == m_FramePts.begin() ? 0 : (uint32_t)(it - m_FramePts.begin() - 1);
+	}
+
+	int64_t VideoSeekIndex::GetFramePts(uint32_t frameIndex) const
+	{
+		if (!IsReady() || m_FramePts.empty())
+			return 0;
+
+		return m_FramePts[std::min(frameIndex, (uint32_t)m_FramePts.size() - 1)];
+	}
+
+}
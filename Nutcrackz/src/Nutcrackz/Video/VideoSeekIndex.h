@@ -0,0 +1,79 @@
+#pragma once
+
+extern "C" {
+	#include <libavformat/avformat.h>
+}
+
+#include "VideoSource.h"
+
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+namespace Nutcrackz {
+
+	struct VideoKeyframe
+	{
+		int64_t Pts = 0;
+		// Byte offset of the keyframe's packet, -1 if the demuxer didn't report one
+		int64_t Position = -1;
+		// Index of the keyframe in presentation order
+		uint32_t FrameIndex = 0;
+	};
+
+	// Keyframe and per-frame timestamp tables of one video stream.
+	// Built by scanning packets (nothing gets decoded) and cached next to the video,
+	// so seeks always know which keyframe they land on and how far it is from the target.
+	// Until it is ready the index is empty, and seeks fall back to asking the demuxer.
+	class VideoSeekIndex
+	{
+	public:
+		VideoSeekIndex() = default;
+		~VideoSeekIndex();
+
+		VideoSeekIndex(const VideoSeekIndex&) = delete;
+		VideoSeekIndex& operator=(const VideoSeekIndex&) = delete;
+
+		// Reads every packet of the stream and rewinds the demuxer to the start afterwards
+		bool Build(AVFormatContext* formatContext, int streamIndex);
+		// Loads the sidecar, or builds the index on a thread of its own through a second demuxer and writes the sidecar.
+		// Scanning a long video takes seconds, so this never blocks the caller.
+		void BuildAsync(const VideoSource& source, int streamIndex);
+		// Blocks until BuildAsync() is done
+		void Wait();
+
+		// The sidecar is rejected if the video changed since it was written
+		bool Load(const std::filesystem::path& sidecarPath, const std::filesystem::path& videoPath, int streamIndex);
+		bool Save(const std::filesystem::path& sidecarPath, const std::filesystem::path& videoPath) const;
+
+		// Videos inside an asset pack get one sidecar per offset next to the pack
+		static std::filesystem::path GetSidecarPath(const VideoSource& source);
+
+		// Last keyframe at or before pts, nullptr if the index is empty
+		const VideoKeyframe* FindKeyframe(int64_t pts) const;
+		// Index of the last frame at or before pts
+		uint32_t FindFrame(int64_t pts) const;
+		int64_t GetFramePts(uint32_t frameIndex) const;
+
+		uint32_t GetFrameCount() const { return IsReady() ? (uint32_t)m_FramePts.size() : 0; }
+		uint32_t GetKeyframeCount() const { return IsReady() ? (uint32_t)m_Keyframes.size() : 0; }
+		bool IsEmpty() const { return !IsReady() || m_Keyframes.empty(); }
+		bool IsReady() const { return m_IsReady.load(std::memory_order_acquire); }
+
+	private:
+		uint32_t FindFrameIndex(int64_t pts) const;
+		void BuildThread(VideoSource source, int streamIndex);
+
+	private:
+		int m_StreamIndex = -1;
+		// Sorted in presentation order. Only written before the index is ready, so readers never need a lock.
+		std::vector<int64_t> m_FramePts;
+		std::vector<VideoKeyframe> m_Keyframes;
+
+		std::atomic<bool> m_IsReady = false;
+		std::atomic<bool> m_IsAborted = false;
+		std::thread m_BuildThread;
+	};
+
+}
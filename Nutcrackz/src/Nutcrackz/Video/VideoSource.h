@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+
+namespace Nutcrackz {
+
+	// Where the bytes of a video come from, either a whole file or a byte range inside one,
+	// like a video that is stored uncompressed in an asset pack
+	struct VideoSource
+	{
+		std::filesystem::path Path;
+		uint64_t Offset = 0;
+		// 0 reads up to the end of the file
+		uint64_t Size = 0;
+
+		VideoSource() = default;
+		VideoSource(const std::filesystem::path& path, uint64_t offset = 0, uint64_t size = 0)
+			: Path(path), Offset(offset), Size(size) {}
+
+		bool IsPacked() const { return Offset != 0 || Size != 0; }
+	};
+
+}
@@ -0,0 +1,106 @@
+#include "nzpch.h"
+#include "VideoStats.h"
+
+#include <chrono>
+
+namespace Nutcrackz {
+
+	namespace Utils {
+
+		// Four buckets per power of two of the duration in 16 ns steps
+		static uint32_t GetTimingBucket(uint64_t nanoseconds)
+		{
+			const uint64_t steps = nanoseconds >> 4;
+			if (steps < 4)
+				return (uint32_t)steps;
+
+			uint32_t octave = 0;
+			while (steps >> (octave + 1))
+				octave++;
+
+			// The two bits below the highest one pick the quarter
+			const uint32_t quarter = (uint32_t)(steps >> (octave - 2)) & 3;
+			return (octave - 1) * 4 + quarter;
+		}
+
+		// Upper edge of a bucket, so percentiles never come out lower than what was measured
+		static uint64_t GetTimingBucketLimit(uint32_t bucket)
+		{
+			if (bucket < 4)
+				return (uint64_t)(bucket + 1) << 4;
+
+			const uint32_t octave = bucket / 4 + 1;
+			const uint32_t quarter = bucket % 4;
+			return ((uint64_t)(5 + quarter) << (octave - 2)) << 4;
+		}
+
+	}
+
+	void VideoStageTimer::Record(uint64_t nanoseconds)
+	{
+		m_Last.store(nanoseconds, std::memory_order_relaxed);
+		m_Total.fetch_add(nanoseconds, std::memory_order_relaxed);
+		m_Count.fetch_add(1, std::memory_order_relaxed);
+
+		const uint32_t bucket = std::min(Utils::GetTimingBucket(nanoseconds), BucketCount - 1);
+		m_Buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	VideoStageTiming VideoStageTimer::GetTiming() const
+	{
+		VideoStageTiming timing;
+		timing.Count = m_Count.load(std::memory_order_relaxed);
+		timing.Last = m_Last.load(std::memory_order_relaxed) / 1e6;
+
+		if (timing.Count == 0)
+			return timing;
+
+		timing.Average = (double)m_Total.load(std::memory_order_relaxed) / timing.Count / 1e6;
+
+		// Buckets are read one by one while they may still be counting, so stop at whatever they add up to
+		const uint64_t rank = (timing.Count * 99 + 99) / 100;
+		uint64_t seen = 0;
+
+		for (uint32_t i = 0; i < BucketCount; i++)
+		{
+			seen += m_Buckets[i].load(std::memory_order_relaxed);
+
+			if (seen >= rank || i == BucketCount - 1)
+			{
+				timing.P99 = Utils::GetTimingBucketLimit(i) / 1e6;
+				break;
+			}
+		}
+
+		return timing;
+	}
+
+	void VideoStageTimer::Reset()
+	{
+		m_Last.store(0, std::memory_order_relaxed);
+		m_Total.store(0, std::memory_order_relaxed);
+		m_Count.store(0, std::memory_order_relaxed);
+
+		for (auto& bucket : m_Buckets)
+			bucket.store(0, std::memory_order_relaxed);
+	}
+
+	void VideoStats::Reset()
+	{
+		Demux.Reset();
+		Decode.Reset();
+		Convert.Reset();
+		Upload.Reset();
+		Present.Reset();
+
+		DroppedFrames = 0;
+		RepeatedFrames = 0;
+		BytesUploaded = 0;
+	}
+
+	uint64_t VideoStats::Now()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+
+namespace Nutcrackz {
+
+	// Milliseconds, averages and percentiles cover everything since the last reset
+	struct VideoStageTiming
+	{
+		double Last = 0.0;
+		double Average = 0.0;
+		double P99 = 0.0;
+		uint64_t Count = 0;
+	};
+
+	// Times one pipeline stage. Recording is a handful of relaxed atomic adds, so it can stay on in the hot path,
+	// percentiles come from a histogram of quarter octaves, which puts them within about 20% of the real value.
+	class VideoStageTimer
+	{
+	public:
+		void Record(uint64_t nanoseconds);
+		VideoStageTiming GetTiming() const;
+		void Reset();
+
+	private:
+		// 16 ns steps up to about a minute
+		static const uint32_t BucketCount = 128;
+
+		std::atomic<uint64_t> m_Last = 0;
+		std::atomic<uint64_t> m_Total = 0;
+		std::atomic<uint64_t> m_Count = 0;
+		std::atomic<uint32_t> m_Buckets[BucketCount] = {};
+	};
+
+	// What VideoTexture::GetStats() hands out
+	struct VideoStatsSnapshot
+	{
+		VideoStageTiming Demux;
+		VideoStageTiming Decode;
+		VideoStageTiming Convert;
+		VideoStageTiming Upload;
+		VideoStageTiming Present;
+
+		uint32_t FrameQueueDepth = 0;
+		uint32_t FrameQueueCapacity = 0;
+		uint32_t AudioPacketQueueDepth = 0;
+		uint32_t AudioBufferedFrames = 0;
+
+		uint64_t DroppedFrames = 0;
+		uint64_t RepeatedFrames = 0;
+		uint64_t AudioUnderruns = 0;
+		uint64_t BytesUploaded = 0;
+	};
+
+	// Counters of one video, written from the decode and render threads while anyone may read them
+	struct VideoStats
+	{
+		VideoStageTimer Demux;
+		VideoStageTimer Decode;
+		VideoStageTimer Convert;
+		VideoStageTimer Upload;
+		VideoStageTimer Present;
+
+		std::atomic<uint64_t> DroppedFrames = 0;
+		std::atomic<uint64_t> RepeatedFrames = 0;
+		std::atomic<uint64_t> BytesUploaded = 0;
+
+		void Reset();
+
+		static uint64_t Now();
+	};
+
+}
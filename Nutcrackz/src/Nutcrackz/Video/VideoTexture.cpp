@@ -1,8 +1,14 @@
 #include "nzpch.h"
 #include "VideoTexture.h"
 
+#include "AudioMixer.h"
+
 #include <glad/glad.h>
 
+extern "C" {
+	#include <libavutil/imgutils.h>
+}
+
 namespace Nutcrackz {
 
 	namespace Utils {
@@ -31,6 +37,41 @@ namespace Nutcrackz {
 			return 0;
 		}
 
+		// Same rule the readers use to pick their stream: the first one of the type we can decode
+		static int FindFirstStream(AVFormatContext* formatContext, AVMediaType type)
+		{
+			for (unsigned int i = 0; i < formatContext->nb_streams; ++i)
+			{
+				const AVCodecParameters* codecParams = formatContext->streams[i]->codecpar;
+
+				if (codecParams->codec_type == type && avcodec_find_decoder(codecParams->codec_id))
+					return (int)i;
+			}
+
+			return -1;
+		}
+
+		// The caller has to flush the video decoder and take over the demuxer's seek serial afterwards
+		static int SeekToKeyframe(VideoReaderState* state, int64_t pts)
+		{
+			auto& avFormatContext = state->VideoFormatContext;
+			auto& demuxer = state->Demuxer;
+			const VideoKeyframe* keyframe = state->SeekIndex ? state->SeekIndex->FindKeyframe(pts) : nullptr;
+
+			int response;
+
+			if (!keyframe)
+				response = demuxer->Seek(state->VideoStreamIndex, pts, AVSEEK_FLAG_BACKWARD, pts);
+			// Formats without a seek table of their own bisect timestamps, going straight to the byte is exact there
+			else if (keyframe->Position >= 0 && (avFormatContext->iformat->flags & AVFMT_TS_DISCONT))
+				response = demuxer->Seek(state->VideoStreamIndex, keyframe->Position, AVSEEK_FLAG_BYTE, pts);
+			// Asking for the keyframe's own pts means the demuxer can't land any earlier than it
+			else
+				response = demuxer->Seek(state->VideoStreamIndex, keyframe->Pts, AVSEEK_FLAG_BACKWARD, pts);
+
+			return response;
+		}
+
 		static AVPixelFormat CorrectForDeprecatedPixelFormat(AVPixelFormat pix_fmt)
 		{
 			// Fix swscaler deprecated pixel format warning
@@ -52,51 +93,6 @@ namespace Nutcrackz {
 			std::string str = av_make_error_string(buffer, AV_ERROR_MAX_STRING_SIZE, errnum);
 			return str;
 		}
-
-		ma_format FromFFmpegAudioToMiniAudioFormat(AVSampleFormat format)
-		{
-			switch (format)
-			{
-				case AV_SAMPLE_FMT_U8: return ma_format_u8;
-				case AV_SAMPLE_FMT_U8P: return ma_format_u8;
-				case AV_SAMPLE_FMT_S16: return ma_format_s16;
-				case AV_SAMPLE_FMT_S16P: return ma_format_s16;
-				case AV_SAMPLE_FMT_S32: return ma_format_s32;
-				case AV_SAMPLE_FMT_S32P: return ma_format_s32;
-				case AV_SAMPLE_FMT_S64: return ma_format_s32;
-				case AV_SAMPLE_FMT_S64P: return ma_format_s32;
-				case AV_SAMPLE_FMT_FLT: return ma_format_f32;
-				case AV_SAMPLE_FMT_FLTP: return ma_format_f32;
-				case AV_SAMPLE_FMT_DBL: return ma_format_f32;
-				case AV_SAMPLE_FMT_DBLP: return ma_format_f32;
-				case AV_SAMPLE_FMT_NONE: return ma_format_unknown;
-			}
-
-			return ma_format_unknown;
-		}
-
-		int FromFFmpegAudioToIntFormat(AVSampleFormat format)
-		{
-			switch (format)
-			{
-				case AV_SAMPLE_FMT_U8: return 0;
-				case AV_SAMPLE_FMT_U8P: return 0;
-				case AV_SAMPLE_FMT_S16: return 1;
-				case AV_SAMPLE_FMT_S16P: return 1;
-				case AV_SAMPLE_FMT_S32: return 2;
-				case AV_SAMPLE_FMT_S32P: return 2;
-				case AV_SAMPLE_FMT_S64: return 10;
-				case AV_SAMPLE_FMT_S64P: return 10;
-				case AV_SAMPLE_FMT_FLT: return 3;
-				case AV_SAMPLE_FMT_FLTP: return 3;
-				case AV_SAMPLE_FMT_DBL: return 4;
-				case AV_SAMPLE_FMT_DBLP: return 4;
-				case AV_SAMPLE_FMT_NONE: return -1;
-			}
-
-			return -1;
-		}
-
 	}
 
 	VideoTexture::VideoTexture(const TextureSpecification& specification)
@@ -115,34 +111,36 @@ namespace Nutcrackz {
 	}
 
 	VideoTexture::VideoTexture(const std::string& path, uint8_t* frameData)
-		: m_VideoPath(path)
+		: VideoTexture(VideoSource(path), frameData)
 	{
-		if (!VideoReaderOpen(&m_VideoState, m_VideoPath))
+	}
+
+	VideoTexture::VideoTexture(const VideoSource& source, uint8_t* frameData)
+		: m_VideoPath(source.Path.string()), m_VideoSource(source)
+	{
+		// Only playback counts, the scrub reader would skew every number
+		m_VideoState.Stats = &m_Stats;
+
+		if (!VideoReaderOpen(&m_VideoState, m_VideoSource))
 		{
 			NZ_CORE_WARN("Couldn't load video file!");
 			return;
 		}
 
+		m_IsVideoLoaded = true;
+
 		const int frameWidth = m_VideoState.Width;
 		const int frameHeight = m_VideoState.Height;
 		frameData = new uint8_t[frameWidth * frameHeight * 4];
 
-		m_Width = frameWidth;
-		m_Height = frameHeight;
-
-		glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
-		glTextureStorage2D(m_RendererID, 1, GL_RGBA8, frameWidth, frameHeight);
-
-		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		CreateStreamingTexture(frameWidth, frameHeight, VideoFrameFormat::RGBA);
 
 		int64_t pts;
-		if (!VideoReaderReadFrame(&m_VideoState, frameData, &pts, false))
+		if (!VideoReaderReadFrame(&m_VideoState, frameData, &pts, false) || m_VideoState.EndOfStream)
 		{
 			NZ_CORE_WARN("Couldn't load video frame!");
+			delete[] frameData;
+			CloseVideo(&m_VideoState);
 			return;
 		}
 
@@ -155,109 +153,526 @@ namespace Nutcrackz {
 		{
 			NZ_CORE_TRACE("Failed to load video texture.");
 		}
+
+		delete[] frameData;
+
+		// Only the first frame was needed up front, playback reopens the file from the start
+		CloseVideo(&m_VideoState);
 	}
 
 	VideoTexture::~VideoTexture()
 	{
+		StopScrubThread();
+		StopDecodeThread();
+		StopAudioThread();
+
+		AudioMixer::RemoveSource(m_AudioSourceID);
+
+		// The queue may point into the ring's mapped memory, so it has to go first
+		m_FrameQueue.Shutdown();
+		m_UploadRing.Shutdown();
+
+		CloseVideo(&m_VideoState);
+
 		glDeleteTextures(1, &m_RendererID);
+		glDeleteTextures(2, m_ChromaRendererIDs);
+	}
+
+	void VideoTexture::SelectOutputFormat()
+	{
+		const AVPixelFormat pixelFormat = m_VideoState.VideoCodecContext->pix_fmt;
+		const bool isYUV420 = pixelFormat == AV_PIX_FMT_YUV420P || pixelFormat == AV_PIX_FMT_YUVJ420P;
+
+		m_VideoState.OutputFormat = m_PreferredFrameFormat == VideoFrameFormat::YUV420 && isYUV420 ? VideoFrameFormat::YUV420 : VideoFrameFormat::RGBA;
 	}
 
-	uint32_t VideoTexture::GetIDFromTexture(uint8_t* frameData, int64_t* pts, bool isPaused)
+	void VideoTexture::CreateStreamingTexture(uint32_t width, uint32_t height, VideoFrameFormat format)
 	{
-		uint32_t rendererID = 0;
+		if (m_RendererID)
+			glDeleteTextures(1, &m_RendererID);
 
-		if (!m_IsVideoLoaded)
+		if (m_ChromaRendererIDs[0])
 		{
-			if (!VideoReaderOpen(&m_VideoState, m_VideoPath))
+			glDeleteTextures(2, m_ChromaRendererIDs);
+			m_ChromaRendererIDs[0] = m_ChromaRendererIDs[1] = 0;
+		}
+
+		m_Width = width;
+		m_Height = height;
+		m_FrameFormat = format;
+
+		// The textures live as long as the video does, frames are streamed into them
+		if (format == VideoFrameFormat::YUV420)
+		{
+			// Luma goes into the main texture, the video shader picks up U and V from the next two slots
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
+			glTextureStorage2D(m_RendererID, 1, GL_R8, width, height);
+
+			glCreateTextures(GL_TEXTURE_2D, 2, m_ChromaRendererIDs);
+
+			for (uint32_t chromaID : m_ChromaRendererIDs)
 			{
-				NZ_CORE_WARN("Couldn't load video file!");
-				return 0;
+				glTextureStorage2D(chromaID, 1, GL_R8, (width + 1) / 2, (height + 1) / 2);
+				glTextureParameteri(chromaID, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+				glTextureParameteri(chromaID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 			}
+		}
+		else
+		{
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_RendererID);
+			glTextureStorage2D(m_RendererID, 1, GL_RGBA8, width, height);
+		}
 
-			m_IsVideoLoaded = true;
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		m_MagFilter = GL_LINEAR;
+
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTextureParameteri(m_RendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	}
+
+	std::vector<VideoTexturePlane> VideoTexture::GetFramePlanes() const
+	{
+		const uint32_t width = m_VideoState.Width;
+		const uint32_t height = m_VideoState.Height;
+
+		if (m_VideoState.OutputFormat == VideoFrameFormat::YUV420)
+		{
+			const uint32_t chromaWidth = (width + 1) / 2;
+			const uint32_t chromaHeight = (height + 1) / 2;
+
+			VideoTexturePlane y = { width, height, 1, 0 };
+			VideoTexturePlane u = { chromaWidth, chromaHeight, 1, y.GetSize() };
+			VideoTexturePlane v = { chromaWidth, chromaHeight, 1, u.Offset + u.GetSize() };
+			return { y, u, v };
 		}
 
+		return { { width, height, 4, 0 } };
+	}
+
+	bool VideoTexture::OpenVideo()
+	{
 		if (m_IsVideoLoaded)
+			return true;
+
+		if (!VideoReaderOpen(&m_VideoState, m_VideoSource))
 		{
-			const int frameWidth = m_Width;
-			const int frameHeight = m_Height;
-			frameData = new uint8_t[frameWidth * frameHeight * 4];
+			NZ_CORE_WARN("Couldn't load video file!");
+			VideoReaderClose(&m_VideoState);
+			return false;
+		}
 
-			if (!VideoReaderReadFrame(&m_VideoState, frameData, pts, isPaused))
-			{
-				NZ_CORE_WARN("Couldn't load video frame!");
-				return 0;
-			}
+		m_VideoState.Demuxer->SetLooping(m_IsLooping);
+
+		m_IsVideoLoaded = true;
+		return true;
+	}
+
+	uint32_t VideoTexture::GetIDFromTexture(uint8_t* frameData, int64_t* pts, bool isPaused, int64_t clockPts)
+	{
+		if (!OpenVideo())
+			return 0;
+
+		if (m_IsVideoLoaded)
+		{
+			const uint64_t presentStart = VideoStats::Now();
+
+			// The seek index may have finished building in the background since the video was opened
+			if (m_VideoState.SeekIndex && !m_VideoState.SeekIndex->IsEmpty())
+				m_VideoState.NumberOfFrames = m_VideoState.SeekIndex->GetFrameCount();
+
+			// Playback takes over from scrubbing, the scrub reader only costs memory and a decoder share from here on
+			if (!isPaused)
+				StopScrubThread();
+
+			if (!m_IsDecoding)
+				SelectOutputFormat();
+
+			if (!m_RendererID || m_FrameFormat != m_VideoState.OutputFormat || m_Width != (uint32_t)m_VideoState.Width || m_Height != (uint32_t)m_VideoState.Height)
+				CreateStreamingTexture(m_VideoState.Width, m_VideoState.Height, m_VideoState.OutputFormat);
+
+			// Demuxing, decoding and conversion all happen on the decode thread,
+			// here we only pick up the next frame that is due for presentation.
+			// A paused video keeps whatever is already in the texture and uploads nothing,
+			// the decode thread goes idle as soon as the queue is full.
+			DecodedVideoFrame* presented = m_FrameQueue.GetPresented();
 
-			if (frameData)
+			if (!isPaused && clockPts != AV_NOPTS_VALUE)
 			{
-				glCreateTextures(GL_TEXTURE_2D, 1, &rendererID);
-				glTextureStorage2D(rendererID, 1, GL_RGBA8, frameWidth, frameHeight);
+				StartDecodeThread();
 
-				if (!m_Specification.UseLinear)
+				// The decode thread may overwrite the replaced slot as soon as we move past it,
+				// so the GPU has to be done reading it before the queue hands it back
+				uint32_t droppedCount;
+				DecodedVideoFrame* frame = m_FrameQueue.PresentDue(clockPts, droppedCount, [this](DecodedVideoFrame* retired)
 				{
-					glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-					glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+					m_UploadRing.Release(retired->Data);
+				});
+				m_Stats.DroppedFrames.fetch_add(droppedCount, std::memory_order_relaxed);
+
+				// Nothing decoded yet just leaves the texture as it is for this tick
+				if (frame && frame != presented)
+				{
+					UploadFrame(frame->Data);
+				}
+				else if (frame && m_FrameQueue.IsBehind(clockPts, m_VideoState.VideoPacketDuration))
+				{
+					// Showing a frame again is only a repeat if the next one is overdue, not when rendering outpaces the video
+					m_Stats.RepeatedFrames.fetch_add(1, std::memory_order_relaxed);
 				}
-				else
+
+				if (frame)
+					*pts = frame->Pts;
+			}
+			else if (!isPaused || !presented)
+			{
+				StartDecodeThread();
+
+				// The decode thread may overwrite this slot as soon as we move past it
+				if (presented)
+					m_UploadRing.Release(presented->Data);
+
+				DecodedVideoFrame* frame = m_FrameQueue.PresentNext();
+
+				if (!frame)
 				{
-					glTextureParameteri(m_RendererID, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-					glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+					NZ_CORE_WARN("Couldn't load video frame!");
+					return 0;
 				}
 
-				glTextureParameteri(rendererID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-				glTextureParameteri(rendererID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+				if (frame != presented)
+					UploadFrame(frame->Data);
 
-				glTextureSubImage2D(rendererID, 0, 0, 0, frameWidth, frameHeight, GL_RGBA, GL_UNSIGNED_BYTE, frameData);
+				if (!isPaused)
+					*pts = frame->Pts;
 			}
 
-			delete[] frameData;
-			frameData = nullptr;
+			const uint32_t magFilter = m_Specification.UseLinear ? GL_LINEAR : GL_NEAREST;
+			if (m_MagFilter != magFilter)
+			{
+				glTextureParameteri(m_RendererID, GL_TEXTURE_MAG_FILTER, magFilter);
+				m_MagFilter = magFilter;
+			}
 
-			m_RendererID = rendererID;
+			m_Stats.Present.Record(VideoStats::Now() - presentStart);
 		}
 
-		return rendererID;
+		return m_RendererID;
+	}
+
+	void VideoTexture::UploadFrame(const uint8_t* frameData)
+	{
+		const uint64_t start = VideoStats::Now();
+
+		const uint32_t textureIDs[3] = { m_RendererID, m_ChromaRendererIDs[0], m_ChromaRendererIDs[1] };
+		m_UploadRing.Upload(textureIDs, frameData);
+
+		m_Stats.Upload.Record(VideoStats::Now() - start);
+		m_Stats.BytesUploaded.fetch_add(m_UploadRing.GetFrameSize(), std::memory_order_relaxed);
+	}
+
+	VideoStatsSnapshot VideoTexture::GetStats()
+	{
+		VideoStatsSnapshot snapshot;
+		snapshot.Demux = m_Stats.Demux.GetTiming();
+		snapshot.Decode = m_Stats.Decode.GetTiming();
+		snapshot.Convert = m_Stats.Convert.GetTiming();
+		snapshot.Upload = m_Stats.Upload.GetTiming();
+		snapshot.Present = m_Stats.Present.GetTiming();
+
+		snapshot.FrameQueueDepth = m_FrameQueue.GetCount();
+		snapshot.FrameQueueCapacity = m_FrameQueue.GetCapacity();
+
+		if (m_VideoState.Demuxer && m_VideoState.AudioStream)
+			snapshot.AudioPacketQueueDepth = m_VideoState.Demuxer->GetQueuedPacketCount(m_VideoState.AudioStreamIndex);
+
+		if (m_VideoState.AudioBuffer)
+		{
+			snapshot.AudioBufferedFrames = m_VideoState.AudioBuffer->GetAvailableRead();
+			snapshot.AudioUnderruns = m_VideoState.AudioBuffer->GetUnderrunCount();
+		}
+
+		snapshot.DroppedFrames = m_Stats.DroppedFrames.load(std::memory_order_relaxed);
+		snapshot.RepeatedFrames = m_Stats.RepeatedFrames.load(std::memory_order_relaxed);
+		snapshot.BytesUploaded = m_Stats.BytesUploaded.load(std::memory_order_relaxed);
+
+		return snapshot;
 	}
 
 	void VideoTexture::DeleteRendererID(const uint32_t& rendererID)
 	{
-		glDeleteTextures(1, &rendererID);
+		// Our own texture is reused for every frame and only released in the destructor
+		if (rendererID != m_RendererID)
+			glDeleteTextures(1, &rendererID);
 	}
 
-	bool VideoTexture::VideoReaderOpen(VideoReaderState* state, const std::filesystem::path& filepath)
+	void VideoTexture::StartDecodeThread()
 	{
-		// Unpack members of state
-		auto& width = state->Width;
-		auto& height = state->Height;
-		auto& timeBase = state->TimeBase;
-		auto& avFormatContext = state->VideoFormatContext;
-		auto& avVideoCodecContext = state->VideoCodecContext;
-		auto& videoStreamIndex = state->VideoStreamIndex;
-		auto& videoStream = state->VideoStream;
-		auto& avFrame = state->VideoFrame;
-		auto& avPacket = state->VideoPacket;
+		if (m_IsDecoding)
+			return;
+
+		const std::vector<VideoTexturePlane> planes = GetFramePlanes();
+		const size_t frameSize = planes.back().Offset + planes.back().GetSize();
+
+		if (m_FrameQueue.GetFrameSize() != frameSize)
+		{
+			m_FrameQueue.Shutdown();
+			m_UploadRing.Init(planes, MaxQueuedFrames, m_PreferredUploadMode);
+			m_FrameQueue.Init(MaxQueuedFrames, frameSize, m_UploadRing.GetPersistentStorage());
+		}
+		else
+		{
+			// Every slot is about to be rewritten, so the GPU has to be done with all of them
+			m_UploadRing.WaitForAll();
+			m_FrameQueue.Flush();
+		}
+
+		m_IsDecoding = true;
+		m_DecodeThread = std::thread(&VideoTexture::DecodeThread, this);
+	}
+
+	void VideoTexture::StopDecodeThread()
+	{
+		if (!m_IsDecoding && !m_DecodeThread.joinable())
+			return;
 
-		avFormatContext = avformat_alloc_context();
+		m_IsDecoding = false;
+		m_FrameQueue.Abort();
+
+		if (m_DecodeThread.joinable())
+			m_DecodeThread.join();
+
+		m_FrameQueue.Flush();
+	}
 
-		if (!avFormatContext)
+	void VideoTexture::DecodeThread()
+	{
+		while (m_IsDecoding)
 		{
-			NZ_CORE_ERROR("Could not create AVFormatContext!");
+			DecodedVideoFrame* frame = m_FrameQueue.BeginPush();
+
+			if (!frame)
+				break;
+
+			if (!VideoReaderReadFrame(&m_VideoState, frame->Data, &frame->Pts, false) || m_VideoState.EndOfStream)
+			{
+				// Nothing more to decode until the next seek restarts this thread
+				m_FrameQueue.Finish();
+				break;
+			}
+
+			m_FrameQueue.EndPush();
+		}
+	}
+
+	bool VideoTexture::PresentCachedFrame(int64_t frameIndex)
+	{
+		if (m_FrameCacheBudget == 0 || !m_IsVideoLoaded || !m_VideoState.SeekIndex || m_VideoState.SeekIndex->IsEmpty())
 			return false;
+
+		const std::vector<VideoTexturePlane> planes = GetFramePlanes();
+		const size_t frameSize = planes.back().Offset + planes.back().GetSize();
+
+		// A different frame size or format makes everything cached so far useless
+		if (m_FrameCache.GetFrameSize() != frameSize)
+		{
+			StopScrubThread();
+			m_FrameCache.Init(frameSize, m_FrameCacheBudget);
 		}
 
-		if (avformat_open_input(&avFormatContext, filepath.string().c_str(), NULL, NULL) < 0)
 		{
-			NZ_CORE_ERROR("Could not open video file: {0}", filepath.string().c_str());
+			std::lock_guard<std::mutex> lock(m_ScrubMutex);
+			m_ScrubTarget = frameIndex;
+		}
+
+		m_ScrubCondition.notify_one();
+		StartScrubThread();
+
+		// The upload ring only knows the frame layout once playback set it up, until then the regular path has to run
+		const bool canUpload = m_UploadRing.GetFrameSize() == frameSize && m_FrameFormat == m_VideoState.OutputFormat
+			&& m_Width == (uint32_t)m_VideoState.Width && m_Height == (uint32_t)m_VideoState.Height;
+
+		if (!canUpload)
 			return false;
+
+		const uint32_t textureIDs[3] = { m_RendererID, m_ChromaRendererIDs[0], m_ChromaRendererIDs[1] };
+		return m_FrameCache.Read(m_VideoState.SeekIndex->GetFramePts((uint32_t)frameIndex), [&](const uint8_t* frameData)
+		{
+			const uint64_t start = VideoStats::Now();
+			m_UploadRing.UploadDirect(textureIDs, frameData);
+
+			m_Stats.Upload.Record(VideoStats::Now() - start);
+			m_Stats.BytesUploaded.fetch_add(frameSize, std::memory_order_relaxed);
+		});
+	}
+
+	void VideoTexture::StartScrubThread()
+	{
+		if (m_IsScrubbing)
+			return;
+
+		// The thread stopped by itself after sitting idle
+		if (m_ScrubThread.joinable())
+			m_ScrubThread.join();
+
+		// The scrub thread reads through a reader of its own, so it never waits on playback or seeks
+		m_ScrubState.SeekIndex = m_VideoState.SeekIndex;
+		m_ScrubState.OutputFormat = m_VideoState.OutputFormat;
+
+		m_IsScrubbing = true;
+		m_ScrubThread = std::thread(&VideoTexture::ScrubThread, this);
+	}
+
+	void VideoTexture::StopScrubThread()
+	{
+		if (!m_ScrubThread.joinable())
+			return;
+
+		{
+			std::lock_guard<std::mutex> lock(m_ScrubMutex);
+			m_IsScrubbing = false;
+		}
+
+		m_ScrubCondition.notify_one();
+		m_ScrubThread.join();
+	}
+
+	void VideoTexture::ScrubThread()
+	{
+		if (!VideoReaderOpen(&m_ScrubState, m_VideoSource))
+		{
+			NZ_CORE_WARN("Couldn't open video file for scrubbing!");
+			VideoReaderClose(&m_ScrubState);
+			return;
+		}
+
+		// The window around the playhead never holds more frames than the cache does,
+		// so filling it can't evict frames of the same window
+		const int64_t capacity = (int64_t)m_FrameCache.GetCapacity();
+		const int64_t framesBehind = (capacity - 1) / 2;
+		const int64_t framesAhead = capacity - 1 - framesBehind;
+		const int64_t lastFrame = (int64_t)m_ScrubState.SeekIndex->GetFrameCount() - 1;
+
+		int64_t filledTarget = -1;
+
+		while (true)
+		{
+			int64_t target;
+
+			{
+				std::unique_lock<std::mutex> lock(m_ScrubMutex);
+				const bool hasWork = m_ScrubCondition.wait_for(lock, std::chrono::milliseconds(ScrubIdleTimeoutMs),
+					[&]() { return !m_IsScrubbing || m_ScrubTarget != filledTarget; });
+
+				// Decided under the lock, so a new target either wakes us or sees us gone and starts a new thread
+				if (!hasWork)
+					m_IsScrubbing = false;
+
+				if (!m_IsScrubbing)
+					break;
+
+				target = std::clamp<int64_t>(m_ScrubTarget, 0, lastFrame);
+			}
+
+			const int64_t first = std::max<int64_t>(0, target - framesBehind);
+			const int64_t last = std::min(lastFrame, target + framesAhead);
+
+			// Frames at and after the playhead matter most, so they are filled before the ones behind it
+			if (FillFrameCache(target, last, first, last) && target > first)
+				FillFrameCache(first, target - 1, first, last);
+
+			filledTarget = target;
 		}
 
-		if (avformat_find_stream_info(avFormatContext, NULL) < 0)
+		VideoReaderClose(&m_ScrubState);
+	}
+
+	bool VideoTexture::FillFrameCache(int64_t firstFrame, int64_t lastFrame, int64_t windowStart, int64_t windowEnd)
+	{
+		VideoReaderState& state = m_ScrubState;
+
+		const int64_t firstPts = state.SeekIndex->GetFramePts((uint32_t)firstFrame);
+		const int64_t lastPts = state.SeekIndex->GetFramePts((uint32_t)lastFrame);
+
+		Utils::SeekToKeyframe(&state, firstPts);
+		avcodec_flush_buffers(state.VideoCodecContext);
+		state.VideoSeekSerial = state.Demuxer->GetSeekSerial();
+
+		int64_t pts = 0;
+
+		while (m_IsScrubbing)
 		{
-			NZ_CORE_ERROR("Could not find stream info!");
+			// Once the playhead leaves the window there's no point in finishing it
+			const int64_t target = m_ScrubTarget;
+			if (target < windowStart || target > windowEnd)
+				return false;
+
+			if (!VideoReaderReadFrame(&state, nullptr, &pts, false) || state.EndOfStream)
+				return true;
+
+			if (pts > lastPts)
+				return true;
+
+			if (pts < firstPts || m_FrameCache.Touch(pts))
+				continue;
+
+			uint8_t* buffer = m_FrameCache.AcquireBuffer();
+
+			if (!VideoReaderConvertFrame(&state, buffer))
+			{
+				m_FrameCache.ReleaseBuffer(buffer);
+				return false;
+			}
+
+			m_FrameCache.Insert(pts, buffer);
+		}
+
+		return false;
+	}
+
+	bool VideoTexture::OpenDemuxer(VideoReaderState* state, const VideoSource& source)
+	{
+		// Video and audio share one demuxer, whichever of them comes first opens it
+		if (!state->Demuxer)
+			state->Demuxer = CreateRef<VideoDemuxer>();
+
+		if (state->Demuxer->IsOpen())
+			return true;
+
+		if (!state->Demuxer->Open(source))
 			return false;
+
+		// Like the converter, the index outlives reopens of the same video.
+		// Building it reads the whole file, so that happens in the background, seeks use the demuxer's own seeking until it's ready.
+		if (!state->SeekIndex)
+		{
+			const int videoStreamIndex = Utils::FindFirstStream(state->Demuxer->GetFormatContext(), AVMEDIA_TYPE_VIDEO);
+
+			state->SeekIndex = CreateRef<VideoSeekIndex>();
+			if (videoStreamIndex >= 0)
+				state->SeekIndex->BuildAsync(source, videoStreamIndex);
 		}
 
+		return true;
+	}
+
+	bool VideoTexture::VideoReaderOpen(VideoReaderState* state, const VideoSource& source)
+	{
+		// Unpack members of state
+		auto& width = state->Width;
+		auto& height = state->Height;
+		auto& timeBase = state->TimeBase;
+		auto& avFormatContext = state->VideoFormatContext;
+		auto& videoStreamIndex = state->VideoStreamIndex;
+		auto& videoStream = state->VideoStream;
+		auto& avFrame = state->VideoFrame;
+		auto& avPacket = state->VideoPacket;
+
+		if (!OpenDemuxer(state, source))
+			return false;
+
+		avFormatContext = state->Demuxer->GetFormatContext();
+
 		if (avFormatContext->duration != AV_NOPTS_VALUE)
 		{
 			state->Duration = avFormatContext->duration + 5000;
@@ -302,6 +717,15 @@ namespace Nutcrackz {
 
 		state->Framerate = av_q2d(avFormatContext->streams[videoStreamIndex]->r_frame_rate);
 
+		// Untagged streams are assumed to be BT.709 from HD upwards, like most players do
+		const AVColorSpace colorSpace = avVideoCodecParams->color_space;
+		const bool isBT709 = colorSpace == AVCOL_SPC_BT709 || (colorSpace == AVCOL_SPC_UNSPECIFIED && height >= 720);
+		state->ColorSpace = isBT709 ? VideoColorSpace::BT709 : VideoColorSpace::BT601;
+
+		const AVPixelFormat pixelFormat = (AVPixelFormat)avVideoCodecParams->format;
+		const bool isFullRange = avVideoCodecParams->color_range == AVCOL_RANGE_JPEG || pixelFormat == AV_PIX_FMT_YUVJ420P;
+		state->ColorRange = isFullRange ? VideoColorRange::Full : VideoColorRange::Limited;
+
 		int hoursToSeconds = state->Hours * 3600;
 		int minutesToSeconds = state->Mins * 60;
 
@@ -317,26 +741,22 @@ namespace Nutcrackz {
 
 		state->VideoPacketDuration = 0;
 
-		// Set-up codec context for the decoder
-		avVideoCodecContext = avcodec_alloc_context3(avVideoCodec);
+		state->Demuxer->AcquireStream(videoStreamIndex);
+		state->VideoSeekSerial = state->Demuxer->GetSeekSerial();
 
-		if (!avVideoCodecContext)
-		{
-			NZ_CORE_ERROR("Could not create avVideoCodecContext!");
-			return false;
-		}
+		// Still the estimate from the frame rate if the index isn't ready yet, GetIDFromTexture() corrects it later
+		if (state->SeekIndex && !state->SeekIndex->IsEmpty())
+			state->NumberOfFrames = state->SeekIndex->GetFrameCount();
 
-		if (avcodec_parameters_to_context(avVideoCodecContext, avVideoCodecParams) < 0)
+		// Every open decoder takes a share of the core budget, including this one
+		if (!state->IsDecoderScheduled)
 		{
-			NZ_CORE_ERROR("Could not initialize avVideoCodecContext!");
-			return false;
+			VideoDecodeScheduler::Register();
+			state->IsDecoderScheduled = true;
 		}
 
-		if (avcodec_open2(avVideoCodecContext, avVideoCodec, NULL) < 0)
-		{
-			NZ_CORE_ERROR("Could not open codec!");
+		if (!OpenVideoDecoder(state))
 			return false;
-		}
 
 		avFrame = av_frame_alloc();
 
@@ -354,9 +774,61 @@ namespace Nutcrackz {
 			return false;
 		}
 
+		// Cached scalers stay valid across reopens, so the converter is kept for the lifetime of the state
+		if (!state->Converter)
+			state->Converter = CreateRef<VideoConverter>();
+
 		return true;
 	}
 
+	bool VideoTexture::OpenVideoDecoder(VideoReaderState* state)
+	{
+		const AVCodecParameters* avVideoCodecParams = state->VideoStream->codecpar;
+		const AVCodec* avVideoCodec = avcodec_find_decoder(avVideoCodecParams->codec_id);
+
+		// Set-up codec context for the decoder
+		AVCodecContext* avVideoCodecContext = avcodec_alloc_context3(avVideoCodec);
+
+		if (!avVideoCodecContext)
+		{
+			NZ_CORE_ERROR("Could not create avVideoCodecContext!");
+			return false;
+		}
+
+		if (avcodec_parameters_to_context(avVideoCodecContext, avVideoCodecParams) < 0)
+		{
+			NZ_CORE_ERROR("Could not initialize avVideoCodecContext!");
+			avcodec_free_context(&avVideoCodecContext);
+			return false;
+		}
+
+		const VideoDecodeThreading threading = VideoDecodeScheduler::GetThreading(avVideoCodec);
+		VideoDecodeScheduler::ApplyThreading(avVideoCodecContext, threading);
+
+		if (avcodec_open2(avVideoCodecContext, avVideoCodec, NULL) < 0)
+		{
+			NZ_CORE_ERROR("Could not open codec!");
+			avcodec_free_context(&avVideoCodecContext);
+			return false;
+		}
+
+		if (state->VideoCodecContext)
+			avcodec_free_context(&state->VideoCodecContext);
+
+		state->VideoCodecContext = avVideoCodecContext;
+		state->DecodeThreadCount = threading.ThreadCount;
+		return true;
+	}
+
+	int64_t VideoTexture::GetFramePts(int64_t frameIndex) const
+	{
+		if (m_VideoState.SeekIndex && !m_VideoState.SeekIndex->IsEmpty())
+			return m_VideoState.SeekIndex->GetFramePts((uint32_t)std::max<int64_t>(frameIndex, 0));
+
+		// Without an index, assume every frame lasts as long as the last one did
+		return frameIndex * m_VideoState.VideoPacketDuration;
+	}
+
 	bool VideoTexture::VideoReaderReadFrame(VideoReaderState* state, uint8_t* frameBuffer, int64_t* pts, bool isPaused)
 	{
 		// Unpack members of state
@@ -370,99 +842,171 @@ namespace Nutcrackz {
 		auto& avPacket = state->VideoPacket;
 		auto& timeBase = state->TimeBase;
 
+		// An audio seek moved the shared demuxer, whatever the decoder still holds is from before that
+		const uint32_t seekSerial = state->Demuxer->GetSeekSerial();
+		if (state->VideoSeekSerial != seekSerial)
+		{
+			avcodec_flush_buffers(avCodecContext);
+			state->VideoSeekSerial = seekSerial;
+		}
+
 		// Decode a single frame
 		int response;
+		state->EndOfStream = true;
+
+		// Summed over every packet that went into the frame
+		uint64_t demuxTime = 0;
+		uint64_t decodeTime = 0;
+		uint64_t time = VideoStats::Now();
+
 		if (avFormatContext != nullptr)
 		{
-			while (av_read_frame(avFormatContext, avPacket) >= 0)
+			while (true)
 			{
-				av_packet_rescale_ts(avPacket, timeBase, timeBase);
+				// Whatever the decoder already holds comes first, with frame threading that's several frames per packet
+				response = avcodec_receive_frame(avCodecContext, avFrame);
 
-				if (avPacket->stream_index != videoStreamIndex)
+				const uint64_t decoded = VideoStats::Now();
+				decodeTime += decoded - time;
+				time = decoded;
+
+				if (response == 0)
 				{
-					av_packet_unref(avPacket);
-					continue;
+					if (state->VideoPacketDuration != avFrame->duration)
+						state->VideoPacketDuration = avFrame->duration;
+
+					state->EndOfStream = false;
+					break;
 				}
 
-				response = avcodec_send_packet(avCodecContext, avPacket);
+				// Drained, every frame of the stream is out
+				if (response == AVERROR_EOF)
+					break;
 
-				if (response < 0)
+				if (response != AVERROR(EAGAIN))
 				{
 					NZ_CORE_ERROR("Failed to decode AVPacket: {0}!", Utils::GetAVError(response));
 					return false;
 				}
 
-				response = avcodec_receive_frame(avCodecContext, avFrame);
+				// The decoder needs more input
+				if (state->Demuxer->ReadPacket(videoStreamIndex, avPacket) < 0)
+				{
+					// Drain whatever the decoder is still holding on to, it reports AVERROR_EOF once it's empty
+					avcodec_send_packet(avCodecContext, nullptr);
+					continue;
+				}
 
-				if (state->VideoPacketDuration != avFrame->duration)
-					state->VideoPacketDuration = avFrame->duration;
+				const uint64_t demuxed = VideoStats::Now();
+				demuxTime += demuxed - time;
+				time = demuxed;
 
-				if (response == AVERROR(EAGAIN) || response == AVERROR_EOF)
+				av_packet_rescale_ts(avPacket, timeBase, timeBase);
+
+				if (avPacket->stream_index != videoStreamIndex)
 				{
 					av_packet_unref(avPacket);
 					continue;
 				}
-				else if (response < 0)
+
+				response = avcodec_send_packet(avCodecContext, avPacket);
+				av_packet_unref(avPacket);
+
+				if (response < 0 && response != AVERROR(EAGAIN))
 				{
 					NZ_CORE_ERROR("Failed to decode AVPacket: {0}!", Utils::GetAVError(response));
 					return false;
 				}
-
-				av_packet_unref(avPacket);
-				break;
 			}
 		}
 
+		// The decoder has unref'd the frame by now, there is nothing to report or convert
+		if (state->EndOfStream)
+			return true;
+
+		if (state->Stats)
+		{
+			state->Stats->Demux.Record(demuxTime);
+			state->Stats->Decode.Record(decodeTime);
+		}
+
 		if (!isPaused)
 		{
 			*pts = avFrame->pts;
 		}
 
-		SwsContext* swsScalerContext;
-		auto srcPixelFormat = Utils::CorrectForDeprecatedPixelFormat(avCodecContext->pix_fmt);
-		swsScalerContext = sws_getContext(width, height, srcPixelFormat, width, height, AV_PIX_FMT_RGB0, SWS_BILINEAR, NULL, NULL, NULL);
+		// Callers that only need to know where the decoder is convert later, if at all
+		if (!frameBuffer)
+			return true;
 
-		if (!swsScalerContext)
-		{
-			NZ_CORE_ERROR("Could not initialize SW Scaler!");
+		return VideoReaderConvertFrame(state, frameBuffer);
+	}
+
+	bool VideoTexture::VideoReaderConvertFrame(VideoReaderState* state, uint8_t* frameBuffer)
+	{
+		// Unpack members of state
+		auto& width = state->Width;
+		auto& height = state->Height;
+		auto& avCodecContext = state->VideoCodecContext;
+		auto& avFrame = state->VideoFrame;
+
+		// Nothing decoded, or already handed back to the decoder
+		if (!avFrame->data[0])
 			return false;
+
+		const uint64_t start = VideoStats::Now();
+
+		if (state->OutputFormat == VideoFrameFormat::YUV420)
+		{
+			// The planes are uploaded as they are and converted by the video shader
+			const int chromaWidth = (width + 1) / 2;
+			const int chromaHeight = (height + 1) / 2;
+
+			uint8_t* y = frameBuffer;
+			uint8_t* u = y + (size_t)width * height;
+			uint8_t* v = u + (size_t)chromaWidth * chromaHeight;
+
+			av_image_copy_plane(y, width, avFrame->data[0], avFrame->linesize[0], width, height);
+			av_image_copy_plane(u, chromaWidth, avFrame->data[1], avFrame->linesize[1], chromaWidth, chromaHeight);
+			av_image_copy_plane(v, chromaWidth, avFrame->data[2], avFrame->linesize[2], chromaWidth, chromaHeight);
+
+			if (state->Stats)
+				state->Stats->Convert.Record(VideoStats::Now() - start);
+
+			return true;
 		}
 
+		auto srcPixelFormat = Utils::CorrectForDeprecatedPixelFormat(avCodecContext->pix_fmt);
+
 		uint8_t* dstBuffer[4] = { frameBuffer, NULL, NULL, NULL };
 		int dstLineSize[4] = { width * 4, 0, 0, 0 };
-		sws_scale(swsScalerContext, avFrame->data, avFrame->linesize, 0, avFrame->height, dstBuffer, dstLineSize);
 
-		sws_freeContext(swsScalerContext);
+		// Unlike the decoder, conversion follows the budget as soon as videos are opened or closed
+		state->Converter->SetConcurrency(VideoDecodeScheduler::GetThreadShare());
 
-		return true;
+		// The yuvj formats were just mapped to plain yuv, so the range has to be handed over explicitly
+		const bool isConverted = state->Converter->Convert(avFrame, srcPixelFormat, dstBuffer, dstLineSize, AV_PIX_FMT_RGB0, width, height,
+			state->ColorSpace, state->ColorRange);
+
+		if (state->Stats)
+			state->Stats->Convert.Record(VideoStats::Now() - start);
+
+		return isConverted;
 	}
 
-	bool m_PauseAudio = false;
-	void ffmpeg_to_miniaudio_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
+	bool VideoTexture::VideoReaderSeekFrame(VideoReaderState* state, int64_t ts)
 	{
-		if (!m_PauseAudio)
-		{
-			AVAudioFifo* fifo = reinterpret_cast<AVAudioFifo*>(pDevice->pUserData);
-			av_audio_fifo_read(fifo, &pOutput, frameCount);
-		}
-		else
-		{
-			size_t len = pDevice->playback.channels * frameCount;
-			switch (pDevice->playback.format)
-			{
-			case ma_format_unknown: 0; break;
-			case ma_format_u8: memset(pOutput, 127, len * 1); break;
-			case ma_format_s16: memset(pOutput, 0, len * 2); break;
-			case ma_format_s24: memset(pOutput, 0, len * 3); break;
-			case ma_format_s32: memset(pOutput, 0, len * 4); break;
-			case ma_format_f32: memset(pOutput, 0, len * 4); break;
-			};
-		}
+		// The decode thread owns the demuxer while it runs, and everything it queued is stale after the seek
+		StopDecodeThread();
+
+		// The reader is closed whenever playback stops, seeking is what reopens it
+		if (!OpenVideo())
+			return false;
 
-		(void)pInput;
+		return VideoReaderSeekTo(state, ts);
 	}
 
-	bool VideoTexture::VideoReaderSeekFrame(VideoReaderState* state, int64_t ts)
+	bool VideoTexture::VideoReaderSeekTo(VideoReaderState* state, int64_t ts)
 	{
 		// Unpack members of state
 		auto& avFormatContext = state->VideoFormatContext;
@@ -474,16 +1018,27 @@ namespace Nutcrackz {
 		auto& timeBase = state->TimeBase;
 
 		int64_t videoPts = av_rescale_q(ts, timeBase, videoStream->time_base);
-		av_seek_frame(avFormatContext, videoStreamIndex, videoPts, AVSEEK_FLAG_BACKWARD);
+		Utils::SeekToKeyframe(state, videoPts);
+
+		// Reopening the decoder costs about as much as flushing it, so this is where it picks up a new thread share
+		bool isRethreaded = false;
+		if (VideoDecodeScheduler::NeedsRebalance(avCodecContext->codec, state->DecodeThreadCount))
+			isRethreaded = OpenVideoDecoder(state);
+
+		if (!isRethreaded)
+			avcodec_flush_buffers(avCodecContext);
 
-		avcodec_flush_buffers(avCodecContext);
+		state->VideoSeekSerial = state->Demuxer->GetSeekSerial();
+
+		if (IsAccurateSeekAvailable(state))
+			return RollForward(state, videoPts);
 
 		// av_seek_frame takes effect after one frame, so I'm decoding one here
 		// so that the next call to video_reader_read_frame() will give the correct frame
 		int response;
 		if (avFormatContext != nullptr)
 		{
-			while (av_read_frame(avFormatContext, avPacket) >= 0)
+			while (state->Demuxer->ReadPacket(videoStreamIndex, avPacket) >= 0)
 			{
 				if (avPacket->stream_index != videoStreamIndex)
 				{
@@ -521,7 +1076,104 @@ namespace Nutcrackz {
 		return true;
 	}
 
-	bool VideoTexture::AudioReaderOpen(VideoReaderState* state, const std::filesystem::path& filepath)
+	bool VideoTexture::RollForward(VideoReaderState* state, int64_t pts)
+	{
+		// Unpack members of state
+		auto& avFormatContext = state->VideoFormatContext;
+		auto& avCodecContext = state->VideoCodecContext;
+		auto& videoStreamIndex = state->VideoStreamIndex;
+		auto& avPacket = state->VideoPacket;
+		auto& avFrame = state->VideoFrame;
+
+		// We stop right after the frame before the target, so the next read returns the target itself.
+		// Landing on the target's keyframe means there's nothing to decode at all.
+		const uint32_t targetFrame = state->SeekIndex->FindFrame(pts);
+		if (targetFrame <= state->SeekIndex->FindKeyframe(pts)->FrameIndex)
+			return true;
+
+		const int64_t previousPts = state->SeekIndex->GetFramePts(targetFrame - 1);
+
+		int response;
+		bool isSuccessful = true;
+		bool isPacketPending = false;
+
+		// Same order as VideoReaderReadFrame(): empty the decoder first, only then feed it the next packet
+		while (true)
+		{
+			// Intermediate frames are only decoded, never converted
+			response = avcodec_receive_frame(avCodecContext, avFrame);
+
+			if (response == 0)
+			{
+				if (avFrame->pts == AV_NOPTS_VALUE || avFrame->pts >= previousPts)
+					break;
+
+				continue;
+			}
+
+			if (response == AVERROR_EOF)
+				break;
+
+			if (response != AVERROR(EAGAIN))
+			{
+				NZ_CORE_ERROR("Failed to decode AVPacket: {0}!", Utils::GetAVError(response));
+				isSuccessful = false;
+				break;
+			}
+
+			if (!isPacketPending)
+			{
+				// The rest of the file goes to the next read, which drains the decoder there
+				if (state->Demuxer->ReadPacket(videoStreamIndex, avPacket) < 0)
+					break;
+
+				if (avPacket->stream_index != videoStreamIndex)
+				{
+					av_packet_unref(avPacket);
+					continue;
+				}
+
+				// Nothing refers back to non-reference frames, so the ones we'd throw away anyway aren't decoded.
+				// Reference frames still are, in full, since the target is predicted from them.
+				const bool isDiscardable = avPacket->pts != AV_NOPTS_VALUE && avPacket->pts < previousPts;
+				const AVDiscard discard = isDiscardable ? AVDISCARD_NONREF : AVDISCARD_DEFAULT;
+				avCodecContext->skip_frame = discard;
+				avCodecContext->skip_idct = discard;
+				avCodecContext->skip_loop_filter = discard;
+			}
+
+			response = avcodec_send_packet(avCodecContext, avPacket);
+
+			// The decoder wants its output read first, the same packet goes in again after that
+			isPacketPending = response == AVERROR(EAGAIN);
+			if (isPacketPending)
+				continue;
+
+			av_packet_unref(avPacket);
+
+			if (response < 0)
+			{
+				NZ_CORE_ERROR("Failed to decode AVPacket: {0}!", Utils::GetAVError(response));
+				isSuccessful = false;
+				break;
+			}
+		}
+
+		// Stopped on a frame that came out before the decoder took the packet, it still belongs to the next read
+		if (isPacketPending)
+		{
+			avcodec_send_packet(avCodecContext, avPacket);
+			av_packet_unref(avPacket);
+		}
+
+		avCodecContext->skip_frame = AVDISCARD_DEFAULT;
+		avCodecContext->skip_idct = AVDISCARD_DEFAULT;
+		avCodecContext->skip_loop_filter = AVDISCARD_DEFAULT;
+
+		return isSuccessful;
+	}
+
+	bool VideoTexture::AudioReaderOpen(VideoReaderState* state, const VideoSource& source)
 	{
 		// Unpack members of state
 		auto& avFormatContext = state->AudioFormatContext;
@@ -531,25 +1183,10 @@ namespace Nutcrackz {
 		auto& avPacket = state->AudioPacket;
 		auto& audioStream = state->AudioStream;
 
-		avFormatContext = avformat_alloc_context();
-
-		if (!avFormatContext)
-		{
-			NZ_CORE_ERROR("Could not create AVFormatContext!");
-			return false;
-		}
-
-		if (avformat_open_input(&avFormatContext, filepath.string().c_str(), NULL, NULL) < 0)
-		{
-			NZ_CORE_ERROR("Could not open video file: {0}", filepath.string().c_str());
+		if (!OpenDemuxer(state, source))
 			return false;
-		}
 
-		if (avformat_find_stream_info(avFormatContext, NULL) < 0)
-		{
-			NZ_CORE_ERROR("Could not find stream info!");
-			return false;
-		}
+		avFormatContext = state->Demuxer->GetFormatContext();
 
 		// Find the first valid video stream inside file!
 		audioStreamIndex = -1;
@@ -581,6 +1218,10 @@ namespace Nutcrackz {
 
 		audioStream = avFormatContext->streams[audioStreamIndex];
 
+		state->Demuxer->AcquireStream(audioStreamIndex);
+		state->AudioSeekSerial = state->Demuxer->GetSeekSerial();
+		state->AudioSkipUntilPts = AV_NOPTS_VALUE;
+
 		avCodecContext = avcodec_alloc_context3(avAudioCodec);
 
 		if (!avCodecContext)
@@ -620,172 +1261,296 @@ namespace Nutcrackz {
 		return true;
 	}
 
-	bool VideoTexture::AudioReaderReadFrame(VideoReaderState* state, bool isPaused)
+	bool VideoTexture::AudioReaderInit(VideoReaderState* state)
 	{
 		// Unpack members of state
-		auto& avFormatContext = state->AudioFormatContext;
-		auto& avCodecContext = state->AudioCodecContext;
-		auto& audioStreamIndex = state->AudioStreamIndex;
-		auto& avFrame = state->AudioFrame;
-		auto& avPacket = state->AudioPacket;
 		auto& audioStream = state->AudioStream;
-		auto& audioFifo = state->AudioFifo;
+		auto& audioBuffer = state->AudioBuffer;
+		auto& audioResampler = state->AudioResampler;
+
+		// Without a device to play on, the stream keeps its own rate and channel count
+		if (!state->AudioOutputSampleRate)
+			state->AudioOutputSampleRate = audioStream->codecpar->sample_rate;
 
-		AVSampleFormat sampleFormat = (AVSampleFormat)audioStream->codecpar->format;
-		int outSampleFormat = Utils::FromFFmpegAudioToIntFormat(sampleFormat);
+		if (!state->AudioOutputChannels)
+			state->AudioOutputChannels = audioStream->codecpar->ch_layout.nb_channels;
 
-		// Initialize SwrContext
-		SwrContext* swrContext = swr_alloc_set_opts(nullptr, audioStream->codecpar->channel_layout, (AVSampleFormat)outSampleFormat, audioStream->codecpar->sample_rate,
-			audioStream->codecpar->channel_layout, sampleFormat, audioStream->codecpar->sample_rate, 0, nullptr);
+		// Once per stream, it picks up the input format from the first decoded frame
+		if (!audioResampler)
+			audioResampler = CreateRef<AudioConverter>(state->AudioOutputSampleRate, state->AudioOutputChannels);
 
-		if (!swrContext)
+		// Only a small window of audio is decoded up front, the audio thread keeps it topped up from here on
+		const int bufferSamples = (int)(state->AudioOutputSampleRate * m_AudioBufferDuration);
+
+		// Twice the window, so a whole decoded frame always fits while we are below it
+		if (!audioBuffer)
 		{
-			NZ_CORE_ERROR("Could not create SwrContext.");
-			return false;
+			audioBuffer = CreateRef<AudioRingBuffer>();
+			audioBuffer->Init(bufferSamples * 2, (uint32_t)sizeof(float) * state->AudioOutputChannels);
 		}
 
-		if (swr_init(swrContext) < 0)
-		{
-			NZ_CORE_ERROR("Could not initialize SwrContext.");
+		return true;
+	}
+
+	bool VideoTexture::AudioReaderReadFrame(VideoReaderState* state, bool isPaused)
+	{
+		// The ring is filled in the mixer's format, so the device has to be open before the resampler is set up
+		if (!AudioMixer::Init())
+			return false;
+
+		state->AudioOutputSampleRate = (int)AudioMixer::GetSampleRate();
+		state->AudioOutputChannels = (int)AudioMixer::GetChannels();
+
+		if (!AudioReaderInit(state))
+			return false;
+
+		const int bufferSamples = (int)(state->AudioOutputSampleRate * m_AudioBufferDuration);
+
+		if (!AudioReaderFillBuffer(state, bufferSamples))
 			return false;
+
+		if (m_InitializedAudio)
+		{
+			// Joining the mix is all it takes to be heard, the device is shared by every video
+			AudioMixer::RemoveSource(m_AudioSourceID);
+			m_AudioSourceID = AudioMixer::AddSource(state->AudioBuffer, m_AudioGain);
+
+			if (!m_AudioSourceID)
+				return false;
+
+			AudioMixer::SetSourcePaused(m_AudioSourceID, isPaused);
+			m_AudioDeviceLatency = AudioMixer::GetLatency();
+
+			m_InitializedAudio = false;
 		}
 
-		audioFifo = av_audio_fifo_alloc((AVSampleFormat)outSampleFormat, audioStream->codecpar->channels, 1);
+		StartAudioThread();
+
+		return true;
+	}
+
+	bool VideoTexture::AudioReaderFillBuffer(VideoReaderState* state, int targetSamples)
+	{
+		// Unpack members of state
+		auto& avFormatContext = state->AudioFormatContext;
+		auto& avCodecContext = state->AudioCodecContext;
+		auto& audioStreamIndex = state->AudioStreamIndex;
+		auto& avFrame = state->AudioFrame;
+		auto& avPacket = state->AudioPacket;
+		auto& audioBuffer = state->AudioBuffer;
+		auto& audioResampler = state->AudioResampler;
+
+		// A video seek moved the shared demuxer, the audio has to follow it
+		if (state->AudioSeekSerial != state->Demuxer->GetSeekSerial())
+			SyncAudioToSeek(state);
 
-		// Decode the video frame data
+		int bufferedSamples = audioBuffer->GetAvailableRead();
+
+		// Decode the audio frame data until the window is full
 		int response;
-		while (av_read_frame(avFormatContext, avPacket) >= 0)
+		while (bufferedSamples < targetSamples && !state->AudioEndOfStream)
 		{
-			if (avPacket->stream_index != audioStreamIndex)
+			// Decoding on with a full ring would only pile the PCM up inside the resampler
+			if (audioBuffer->GetAvailableWrite() == 0)
+				break;
+
+			response = avcodec_receive_frame(avCodecContext, avFrame);
+
+			if (response == 0)
 			{
-				av_packet_unref(avPacket);
+				// Every frame re-anchors the clock, so gaps in the stream don't make it drift.
+				// The first sample written is whatever the resampler still held from before this frame.
+				if (avFrame->best_effort_timestamp != AV_NOPTS_VALUE)
+					audioBuffer->SetTimestamp(avFrame->best_effort_timestamp * av_q2d(state->AudioStream->time_base) - audioResampler->GetDelay());
+
+				response = audioResampler->Convert(avFrame, *audioBuffer);
+				av_frame_unref(avFrame);
+
+				if (response < 0)
+				{
+					NZ_CORE_ERROR("Failed to resample audio frame: {0}!", Utils::GetAVError(response));
+					return false;
+				}
+
+				bufferedSamples = audioBuffer->GetAvailableRead();
 				continue;
 			}
 
-			response = avcodec_send_packet(avCodecContext, avPacket);
+			if (response == AVERROR_EOF)
+			{
+				state->AudioEndOfStream = true;
+				audioBuffer->MarkEndOfStream();
+				break;
+			}
 
-			if (state->AudioPacketDuration != avPacket->duration)
-				state->AudioPacketDuration = avPacket->duration;
+			if (response != AVERROR(EAGAIN))
+			{
+				NZ_CORE_ERROR("Failed to decode audio frame: {0}!", Utils::GetAVError(response));
+				return false;
+			}
 
-			if (response < 0)
+			// The decoder needs more input
+			if (state->Demuxer->ReadPacket(audioStreamIndex, avPacket) < 0)
 			{
-				if (response != AVERROR(EAGAIN))
+				// Drain whatever the decoder is still holding on to
+				avcodec_send_packet(avCodecContext, nullptr);
+				continue;
+			}
+
+			if (avPacket->stream_index != audioStreamIndex)
+			{
+				av_packet_unref(avPacket);
+				continue;
+			}
+
+			// Seeks land on the video's keyframe, the audio between there and the seek target is dropped
+			if (state->AudioSkipUntilPts != AV_NOPTS_VALUE && avPacket->pts != AV_NOPTS_VALUE)
+			{
+				if (avPacket->pts + avPacket->duration <= state->AudioSkipUntilPts)
 				{
-					NZ_CORE_ERROR("Could not decode packet.");
 					av_packet_unref(avPacket);
 					continue;
 				}
+
+				state->AudioSkipUntilPts = AV_NOPTS_VALUE;
 			}
 
-			while ((response = avcodec_receive_frame(avCodecContext, avFrame)) == 0)
-			{
-				AVFrame* resampledFrame = av_frame_alloc();
-				resampledFrame->sample_rate = avFrame->sample_rate;
-				resampledFrame->channel_layout = avFrame->channel_layout;
-				resampledFrame->channels = avFrame->channels;
-				resampledFrame->format = outSampleFormat;
+			if (state->AudioPacketDuration != avPacket->duration)
+				state->AudioPacketDuration = avPacket->duration;
 
-				response = swr_convert_frame(swrContext, resampledFrame, avFrame);
+			response = avcodec_send_packet(avCodecContext, avPacket);
+			av_packet_unref(avPacket);
 
-				av_frame_unref(avFrame);
-				av_audio_fifo_write(audioFifo, (void**)resampledFrame->data, resampledFrame->nb_samples);
-				av_frame_free(&resampledFrame);
-			}
+			if (response < 0 && response != AVERROR(EAGAIN))
+				NZ_CORE_ERROR("Could not decode packet.");
 		}
 
-		if (m_InitializedAudio)
-		{
-			ma_device_config deviceConfig;
-			deviceConfig = ma_device_config_init(ma_device_type_playback);
-			deviceConfig.playback.format = Utils::FromFFmpegAudioToMiniAudioFormat(sampleFormat);
-			deviceConfig.playback.channels = audioStream->codecpar->channels;
-			deviceConfig.sampleRate = audioStream->codecpar->sample_rate;
-			deviceConfig.dataCallback = ffmpeg_to_miniaudio_callback;
-			deviceConfig.pUserData = audioFifo;
+		return true;
+	}
 
-			if (ma_device_init(NULL, &deviceConfig, &m_AudioDevice) != MA_SUCCESS)
-			{
-				NZ_CORE_ERROR("Failed to open playback device!");
-				return false;
-			}
+	bool VideoTexture::GetAudioClock(double& seconds) const
+	{
+		const AudioRingBuffer* audioBuffer = m_VideoState.AudioBuffer.get();
 
-			if (ma_device_start(&m_AudioDevice) != MA_SUCCESS)
-			{
-				NZ_CORE_ERROR("Failed to start playback device!");
-				ma_device_uninit(&m_AudioDevice);
-				return false;
-			}
+		if (!m_HasLoadedAudio || m_InitializedAudio || m_PauseAudio || !audioBuffer || !m_VideoState.AudioStream)
+			return false;
 
-			swr_free(&swrContext);
+		// Audio that ended before the video would hold the video back, it runs on its own clock from there
+		if (m_VideoState.AudioEndOfStream && audioBuffer->GetAvailableRead() == 0)
+			return false;
 
-			m_InitializedAudio = false;
-		}
+		if (!audioBuffer->GetReadTimestamp(m_VideoState.AudioOutputSampleRate, seconds))
+			return false;
 
+		seconds = std::max(0.0, seconds - m_AudioDeviceLatency);
 		return true;
 	}
 
+	void VideoTexture::StartAudioThread()
+	{
+		if (m_IsDecodingAudio || !m_VideoState.AudioBuffer || m_VideoState.AudioEndOfStream)
+			return;
+
+		if (m_AudioThread.joinable())
+			m_AudioThread.join();
+
+		m_IsDecodingAudio = true;
+		m_AudioThread = std::thread(&VideoTexture::AudioThread, this);
+	}
+
+	void VideoTexture::StopAudioThread()
+	{
+		m_IsDecodingAudio = false;
+
+		if (m_AudioThread.joinable())
+			m_AudioThread.join();
+	}
+
+	void VideoTexture::AudioThread()
+	{
+		const int bufferSamples = (int)(m_VideoState.AudioOutputSampleRate * m_AudioBufferDuration);
+		const int lowWatermark = bufferSamples / 2;
+
+		while (m_IsDecodingAudio && !m_VideoState.AudioEndOfStream)
+		{
+			const int bufferedSamples = m_VideoState.AudioBuffer->GetAvailableRead();
+
+			if (bufferedSamples < lowWatermark && !AudioReaderFillBuffer(&m_VideoState, bufferSamples))
+				break;
+
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+
+		m_IsDecodingAudio = false;
+	}
+
+	void VideoTexture::ResetAudioBuffer(VideoReaderState* state)
+	{
+		// Only ever called while the audio thread is stopped, so we are the producer here
+		if (state->AudioBuffer)
+			state->AudioBuffer->Reset();
+
+		if (state->AudioResampler)
+			state->AudioResampler->Reset();
+
+		state->AudioEndOfStream = false;
+	}
+
+	void VideoTexture::SyncAudioToSeek(VideoReaderState* state)
+	{
+		uint32_t seekSerial;
+		int64_t seekTarget;
+		state->Demuxer->GetSeekPoint(seekSerial, seekTarget);
+
+		avcodec_flush_buffers(state->AudioCodecContext);
+		ResetAudioBuffer(state);
+
+		state->AudioSeekSerial = seekSerial;
+		state->AudioSkipUntilPts = seekTarget == AV_NOPTS_VALUE ? AV_NOPTS_VALUE : av_rescale_q(seekTarget, AV_TIME_BASE_Q, state->AudioStream->time_base);
+	}
+
 	bool VideoTexture::AudioReaderSeekFrame(VideoReaderState* state, int64_t ts, bool resetAudio)
 	{
 		// Unpack members of state
-		auto& audioFormatContext = state->AudioFormatContext;
-		auto& audioCodecContext = state->AudioCodecContext;
 		auto& audioStreamIndex = state->AudioStreamIndex;
-		auto& audioPacket = state->AudioPacket;
-		auto& audioFrame = state->AudioFrame;
 		auto& audioStream = state->AudioStream;
 		auto& timeBase = state->TimeBase;
 
-		int64_t pts = av_rescale_q(ts, timeBase, audioStream->time_base);
-		av_seek_frame(audioFormatContext, audioStreamIndex, pts, AVSEEK_FLAG_BACKWARD);
-
-		avcodec_flush_buffers(audioCodecContext);
-
-		// av_seek_frame takes effect after one frame, so I'm decoding one here
-		// so that the next call to video_reader_read_frame() will give the correct frame
-		int response;
-		if (audioFormatContext != nullptr)
-		{
-			while (av_read_frame(audioFormatContext, audioPacket) >= 0)
-			{
-				if (audioPacket->stream_index != audioStreamIndex)
-				{
-					av_packet_unref(audioPacket);
-					continue;
-				}
+		// The audio thread owns the decoder while it runs, and the buffered PCM is stale after the seek
+		StopAudioThread();
+		ResetAudioBuffer(state);
 
-				response = avcodec_send_packet(audioCodecContext, audioPacket);
-				if (response < 0)
-				{
-					NZ_CORE_ERROR("Failed to decode audio packet: {0}!", Utils::GetAVError(response));
-					return false;
-				}
+		// The demuxer is shared with the decode thread, and the frames it queued would be measured against
+		// an audio clock that is about to jump. The next GetIDFromTexture() starts it again from the new position.
+		if (state->VideoStream)
+			StopDecodeThread();
 
-				response = avcodec_receive_frame(audioCodecContext, audioFrame);
+		int64_t pts = av_rescale_q(ts, timeBase, audioStream->time_base);
 
-				if (response == AVERROR(EAGAIN) || response == AVERROR_EOF)
-				{
-					av_packet_unref(audioPacket);
-					continue;
-				}
-				else if (response < 0)
-				{
-					NZ_CORE_ERROR("Failed to decode audio packet: {0}!", Utils::GetAVError(response));
-					return false;
-				}
+		// The demuxer is shared, so with the video open the seek has to land somewhere the video can decode from.
+		// The audio drops whatever comes before ts itself.
+		if (state->VideoStream)
+			Utils::SeekToKeyframe(state, av_rescale_q(ts, timeBase, state->VideoStream->time_base));
+		else
+			state->Demuxer->Seek(audioStreamIndex, pts, AVSEEK_FLAG_BACKWARD, pts);
 
-				av_packet_unref(audioPacket);
-				break;
-			}
+		SyncAudioToSeek(state);
 
-			if (resetAudio && !m_InitializedAudio)
-				m_InitializedAudio = true;
-		}
+		if (resetAudio && !m_InitializedAudio)
+			m_InitializedAudio = true;
 
 		return true;
 	}
 
 	bool VideoTexture::AVReaderSeekFrame(VideoReaderState* state, int64_t ts, bool resetAudio)
 	{
+		// The decode thread owns the demuxer while it runs, and everything it queued is stale after the seek
+		StopDecodeThread();
+
+		// The reader is closed whenever playback stops, seeking is what reopens it
+		if (!OpenVideo())
+			return false;
+
 		// Unpack video members of state
 		auto& videoFormatContext = state->VideoFormatContext;
 		auto& videoCodecContext = state->VideoCodecContext;
@@ -795,25 +1560,26 @@ namespace Nutcrackz {
 		auto& videoStream = state->VideoStream;
 
 		// Unpack members of state
-		auto& audioFormatContext = state->AudioFormatContext;
-		auto& audioCodecContext = state->AudioCodecContext;
-		auto& audioStreamIndex = state->AudioStreamIndex;
-		auto& audioPacket = state->AudioPacket;
-		auto& audioFrame = state->AudioFrame;
 		auto& audioStream = state->AudioStream;
 		auto& timeBase = state->TimeBase;
 
 		int64_t videoPts = av_rescale_q(ts, timeBase, videoStream->time_base);
-		av_seek_frame(videoFormatContext, videoStreamIndex, videoPts, AVSEEK_FLAG_BACKWARD);
+		Utils::SeekToKeyframe(state, videoPts);
 
 		avcodec_flush_buffers(videoCodecContext);
+		state->VideoSeekSerial = state->Demuxer->GetSeekSerial();
 
 		// av_seek_frame takes effect after one frame, so I'm decoding one here
 		// so that the next call to video_reader_read_frame() will give the correct frame
 		int response;
-		if (videoFormatContext != nullptr)
+		if (IsAccurateSeekAvailable(state))
+		{
+			if (!RollForward(state, videoPts))
+				return false;
+		}
+		else if (videoFormatContext != nullptr)
 		{
-			while (av_read_frame(videoFormatContext, videoPacket) >= 0)
+			while (state->Demuxer->ReadPacket(videoStreamIndex, videoPacket) >= 0)
 			{
 				if (videoPacket->stream_index != videoStreamIndex)
 				{
@@ -845,118 +1611,162 @@ namespace Nutcrackz {
 			}
 		}
 
-		int64_t audioPts = av_rescale_q(ts, timeBase, audioStream->time_base);
-		av_seek_frame(audioFormatContext, audioStreamIndex, audioPts, AVSEEK_FLAG_BACKWARD);
+		// The audio may have been closed already, then there's nothing left to move
+		if (!audioStream)
+			return true;
 
-		avcodec_flush_buffers(audioCodecContext);
+		// The video seek above moved the shared demuxer for the audio as well
+		StopAudioThread();
+		ResetAudioBuffer(state);
+		SyncAudioToSeek(state);
 
-		// av_seek_frame takes effect after one frame, so I'm decoding one here
-		// so that the next call to video_reader_read_frame() will give the correct frame
-		if (audioFormatContext != nullptr)
-		{
-			while (av_read_frame(audioFormatContext, audioPacket) >= 0)
-			{
-				if (audioPacket->stream_index != audioStreamIndex)
-				{
-					av_packet_unref(audioPacket);
-					continue;
-				}
+		if (resetAudio && !m_InitializedAudio)
+			m_InitializedAudio = true;
 
-				response = avcodec_send_packet(audioCodecContext, audioPacket);
-				if (response < 0)
-				{
-					NZ_CORE_ERROR("Failed to decode audio packet: {0}!", Utils::GetAVError(response));
-					return false;
-				}
+		return true;
+	}
+
+	void VideoTexture::PauseAudio(bool isPaused)
+	{
+		if (m_PauseAudio != isPaused)
+		{
+			m_PauseAudio = isPaused;
+			AudioMixer::SetSourcePaused(m_AudioSourceID, isPaused);
+		}
+	}
 
-				response = avcodec_receive_frame(audioCodecContext, audioFrame);
+	void VideoTexture::SetVolume(float gain)
+	{
+		if (m_AudioGain != gain)
+		{
+			m_AudioGain = gain;
+			AudioMixer::SetSourceGain(m_AudioSourceID, gain);
+		}
+	}
 
-				if (response == AVERROR(EAGAIN) || response == AVERROR_EOF)
-				{
-					av_packet_unref(audioPacket);
-					continue;
-				}
-				else if (response < 0)
-				{
-					NZ_CORE_ERROR("Failed to decode audio packet: {0}!", Utils::GetAVError(response));
-					return false;
-				}
+	bool VideoTexture::StopAndRewind(VideoReaderState* state)
+	{
+		// The mixer skips the source while it's paused, the shared device is never touched
+		PauseAudio(true);
 
-				av_packet_unref(audioPacket);
-				break;
-			}
+		if (m_HasLoadedAudio && state->AudioStream)
+		{
+			// Rewinds the shared demuxer for both streams and stops the audio thread
+			if (!AVReaderSeekFrame(state, 0))
+				return false;
 
-			if (resetAudio && !m_InitializedAudio)
-				m_InitializedAudio = true;
+			// Have the first window ready, so the audio doesn't start on an underrun
+			const int bufferSamples = (int)(state->AudioOutputSampleRate * m_AudioBufferDuration);
+			if (!m_InitializedAudio && !AudioReaderFillBuffer(state, bufferSamples))
+				return false;
+		}
+		else if (!VideoReaderSeekFrame(state, 0))
+		{
+			return false;
 		}
 
 		return true;
 	}
 
-	void VideoTexture::PauseAudio(bool isPaused)
+	void VideoTexture::SetLooping(bool isLooping)
 	{
-		if (m_PauseAudio != isPaused)
-			m_PauseAudio = isPaused;
+		m_IsLooping = isLooping;
+
+		if (m_VideoState.Demuxer)
+			m_VideoState.Demuxer->SetLooping(isLooping);
+	}
+
+	uint32_t VideoTexture::GetLoopCount() const
+	{
+		return m_VideoState.Demuxer ? m_VideoState.Demuxer->GetLoopCount() : 0;
+	}
+
+	double VideoTexture::GetLoopDuration() const
+	{
+		return m_VideoState.Demuxer ? (double)m_VideoState.Demuxer->GetLoopDuration() / AV_TIME_BASE : 0.0;
 	}
 
 	void VideoTexture::CloseVideo(VideoReaderState* state)
 	{
-		if (m_IsVideoLoaded)
-		{
-			if (state->VideoFormatContext)
-				avformat_close_input(&state->VideoFormatContext);
+		StopDecodeThread();
+
+		VideoReaderClose(state);
+		m_IsVideoLoaded = false;
+	}
+
+	void VideoTexture::VideoReaderClose(VideoReaderState* state)
+	{
+		// The demuxer closes itself once the audio is done with it too
+		if (state->VideoStream)
+			state->Demuxer->ReleaseStream(state->VideoStreamIndex);
+
+		state->VideoFormatContext = nullptr;
 
-			if (state->VideoFormatContext)
-				avformat_free_context(state->VideoFormatContext);
+		if (state->VideoFrame)
+			av_frame_free(&state->VideoFrame);
 
-			if (state->VideoFrame)
-				av_frame_free(&state->VideoFrame);
+		if (state->VideoPacket)
+			av_packet_free(&state->VideoPacket);
 
-			if (state->VideoPacket)
-				av_packet_free(&state->VideoPacket);
+		if (state->VideoCodecContext)
+			avcodec_free_context(&state->VideoCodecContext);
 
-			if (state->VideoCodecContext)
-				avcodec_free_context(&state->VideoCodecContext);
+		state->VideoStream = nullptr;
 
-			m_IsVideoLoaded = false;
+		if (state->IsDecoderScheduled)
+		{
+			VideoDecodeScheduler::Unregister();
+			state->IsDecoderScheduled = false;
 		}
 	}
 
 	void VideoTexture::CloseAudio(VideoReaderState* state)
 	{
-		if (ma_device_stop(&m_AudioDevice) != MA_SUCCESS)
-		{
-			NZ_CORE_ERROR("Failed to stop playback device!");
-			ma_device_uninit(&m_AudioDevice);
-			return;
-		}
+		// Only this video leaves the mix, the device keeps running for the others
+		AudioMixer::RemoveSource(m_AudioSourceID);
+		m_AudioSourceID = 0;
 
 		m_AudioStopped = true;
 
 		if (m_HasLoadedAudio)
 		{
-			avformat_close_input(&state->AudioFormatContext);
-			av_frame_free(&state->AudioFrame);
-			av_packet_free(&state->AudioPacket);
-			avcodec_free_context(&state->AudioCodecContext);
-
-			av_audio_fifo_free(state->AudioFifo);
-			ma_device_uninit(&m_AudioDevice);
+			StopAudioThread();
+			AudioReaderClose(state);
 
 			m_HasLoadedAudio = false;
 		}
 	}
 
+	void VideoTexture::AudioReaderClose(VideoReaderState* state)
+	{
+		if (state->AudioStream)
+			state->Demuxer->ReleaseStream(state->AudioStreamIndex);
+
+		state->AudioFormatContext = nullptr;
+		state->AudioStream = nullptr;
+		av_frame_free(&state->AudioFrame);
+		av_packet_free(&state->AudioPacket);
+		avcodec_free_context(&state->AudioCodecContext);
+		state->AudioResampler = nullptr;
+
+		state->AudioBuffer = nullptr;
+		state->AudioEndOfStream = false;
+		state->AudioOutputSampleRate = 0;
+		state->AudioOutputChannels = 0;
+	}
+
 	void VideoTexture::ReadAndPlayAudio(VideoReaderState* state, int64_t ts, bool seek, bool isPaused)
 	{
 		if (!m_HasLoadedAudio)
 		{
-			if (!AudioReaderOpen(&m_VideoState, m_VideoPath))
+			if (!AudioReaderOpen(&m_VideoState, m_VideoSource))
 			{
 				NZ_CORE_WARN("Couldn't load video file!");
 				return;
 			}
 
+			m_VideoState.Demuxer->SetLooping(m_IsLooping);
+
 			m_AudioStopped = false;
 			m_InitializedAudio = true;
 
@@ -983,6 +1793,13 @@ namespace Nutcrackz {
 			}
 		}
 
+		// Seeking stops the audio thread, pick up refilling the buffer where the seek left off.
+		// While paused the device only plays silence, so the buffer stays as full as it is.
+		if (!isPaused)
+			StartAudioThread();
+		else
+			StopAudioThread();
+
 		PauseAudio(isPaused);
 	}
 
@@ -991,11 +1808,6 @@ namespace Nutcrackz {
 		state->AudioPacketDuration = 0;
 	}
 
-	VideoReaderState VideoTexture::GetVideoState()
-	{
-		return m_VideoState;
-	};
-
 	void VideoTexture::SetWidth(uint32_t width)
 	{
 		m_Width = width;
@@ -1023,6 +1835,12 @@ namespace Nutcrackz {
 		//NZ_PROFILE_FUNCTION();
 
 		glBindTextureUnit(slot, m_RendererID);
+
+		if (m_FrameFormat == VideoFrameFormat::YUV420)
+		{
+			glBindTextureUnit(slot + 1, m_ChromaRendererIDs[0]);
+			glBindTextureUnit(slot + 2, m_ChromaRendererIDs[1]);
+		}
 	}
 
 	Ref<VideoTexture> VideoTexture::Create(const TextureSpecification& specification)
@@ -1035,4 +1853,9 @@ namespace Nutcrackz {
 		return CreateRef<VideoTexture>(path, frameData);
 	}
 
+	Ref<VideoTexture> VideoTexture::Create(const VideoSource& source, uint8_t* frameData)
+	{
+		return CreateRef<VideoTexture>(source, frameData);
+	}
+
 }
\ No newline at end of file
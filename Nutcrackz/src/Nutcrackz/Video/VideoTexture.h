@@ -4,7 +4,18 @@
 #include "Nutcrackz/Renderer/Texture.h"
 #include "Nutcrackz/Asset/Asset.h"
 
-#include "miniaudio.h"
+#include "AudioConverter.h"
+#include "AudioRingBuffer.h"
+#include "VideoColorConversion.h"
+#include "VideoConverter.h"
+#include "VideoDecodeScheduler.h"
+#include "VideoDemuxer.h"
+#include "VideoFrameCache.h"
+#include "VideoFrameQueue.h"
+#include "VideoPixelBufferRing.h"
+#include "VideoSeekIndex.h"
+#include "VideoSource.h"
+#include "VideoStats.h"
 
 extern "C" {
 	#include <libavcodec/avcodec.h>
@@ -12,11 +23,14 @@ extern "C" {
 	#include <libswscale/swscale.h>
 	#include <libavutil/error.h>
 	#include <libavutil/avutil.h>
-	#include <libswresample/swresample.h>
 	#include <libavutil/audio_fifo.h>
 }
 
+#include <atomic>
+#include <condition_variable>
 #include <filesystem>
+#include <mutex>
+#include <thread>
 
 namespace Nutcrackz {
 
@@ -31,20 +45,57 @@ namespace Nutcrackz {
 		int64_t NumberOfFrames;
 		int VideoStreamIndex = -1;
 		int AudioStreamIndex = -1;
+		bool EndOfStream = false;
+		bool IsDecoderScheduled = false;
+		int DecodeThreadCount = 1;
+
+		VideoFrameFormat OutputFormat = VideoFrameFormat::RGBA;
+		VideoColorSpace ColorSpace = VideoColorSpace::BT601;
+		VideoColorRange ColorRange = VideoColorRange::Limited;
 
 		AVRational TimeBase;
+		// Both format contexts are the demuxer's, they are only kept here for convenience
+		Ref<VideoDemuxer> Demuxer;
 		AVFormatContext* VideoFormatContext = nullptr;
 		AVCodecContext* VideoCodecContext = nullptr;
 		AVFrame* VideoFrame = nullptr;
 		AVPacket* VideoPacket = nullptr;
 		AVStream* VideoStream = nullptr;
+		uint32_t VideoSeekSerial = 0;
 
 		AVFormatContext* AudioFormatContext = nullptr;
 		AVCodecContext* AudioCodecContext = nullptr;
 		AVFrame* AudioFrame = nullptr;
 		AVPacket* AudioPacket = nullptr;
 		AVStream* AudioStream = nullptr;
-		AVAudioFifo* AudioFifo = nullptr;
+		Ref<AudioRingBuffer> AudioBuffer;
+		Ref<AudioConverter> AudioResampler;
+		// What the ring holds as interleaved 32-bit float, the mixer's format when playing.
+		// AudioReaderInit() falls back to the stream's own rate and channel count if these are 0.
+		int AudioOutputSampleRate = 0;
+		int AudioOutputChannels = 0;
+		// Set by the audio thread, read by the render thread
+		std::atomic<bool> AudioEndOfStream = false;
+		uint32_t AudioSeekSerial = 0;
+		int64_t AudioSkipUntilPts = AV_NOPTS_VALUE;
+
+		Ref<VideoConverter> Converter;
+		Ref<VideoSeekIndex> SeekIndex;
+
+		// Where the reader records its timings, null to not record them
+		VideoStats* Stats = nullptr;
+	};
+
+	// Playback bookkeeping that VideoRenderer keeps for every video
+	struct VideoPlaybackState
+	{
+		uint64_t TimerOffset = 0;
+		double RestartPointFromPause = 0.0;
+		double PresentationTimeInSeconds = 0.0;
+		double VideoDuration = 0.0;
+		bool IsRenderingVideo = false;
+		int64_t FramePosition = 0;
+		bool SeekAudio = false;
 	};
 
 	class VideoTexture : public Asset
@@ -52,27 +103,101 @@ namespace Nutcrackz {
 	public:
 		VideoTexture(const TextureSpecification& specification);
 		VideoTexture(const std::string& path, uint8_t* frameData);
+		// Streams the video straight out of its byte range, used for videos inside asset packs
+		VideoTexture(const VideoSource& source, uint8_t* frameData);
 		
 		~VideoTexture();
 
-		uint32_t GetIDFromTexture(uint8_t* frameData, int64_t* pts, bool isPaused);
+		// With a clock pts the newest frame that is due by then is shown and nothing ever waits,
+		// without one this waits for the next decoded frame, which is what stills and seeks want
+		uint32_t GetIDFromTexture(uint8_t* frameData, int64_t* pts, bool isPaused, int64_t clockPts = AV_NOPTS_VALUE);
 		void DeleteRendererID(const uint32_t& rendererID);
 
-		static bool VideoReaderOpen(VideoReaderState* state, const std::filesystem::path& filepath);
-		bool VideoReaderReadFrame(VideoReaderState* state, uint8_t* frameBuffer, int64_t* pts, bool isPaused);
+		static void SetPreferredUploadMode(VideoUploadMode mode) { m_PreferredUploadMode = mode; }
+		VideoUploadMode GetUploadMode() const { return m_UploadRing.GetMode(); }
+
+		// YUV420 is only used for 8-bit 4:2:0 sources, everything else is still converted to RGBA
+		static void SetPreferredFrameFormat(VideoFrameFormat format) { m_PreferredFrameFormat = format; }
+		VideoFrameFormat GetFrameFormat() const { return m_FrameFormat; }
+		int GetShaderPixelFormat() const { return GetVideoShaderFormat(m_FrameFormat, m_VideoState.ColorSpace, m_VideoState.ColorRange, m_Specification.UseLinear); }
+		uint32_t GetTextureSlotCount() const { return m_FrameFormat == VideoFrameFormat::YUV420 ? 3 : 1; }
+
+		void StartDecodeThread();
+		void StopDecodeThread();
+		bool IsDecoding() const { return m_IsDecoding; }
+
+		static bool OpenDemuxer(VideoReaderState* state, const VideoSource& source);
+		static bool VideoReaderOpen(VideoReaderState* state, const VideoSource& source);
+		static bool OpenVideoDecoder(VideoReaderState* state);
+		static void VideoReaderClose(VideoReaderState* state);
+		// frameBuffer may be null to only decode, VideoReaderConvertFrame() can still convert the frame afterwards
+		static bool VideoReaderReadFrame(VideoReaderState* state, uint8_t* frameBuffer, int64_t* pts, bool isPaused);
+		static bool VideoReaderConvertFrame(VideoReaderState* state, uint8_t* frameBuffer);
+		static bool RollForward(VideoReaderState* state, int64_t pts);
 		bool VideoReaderSeekFrame(VideoReaderState* state, int64_t ts);
-		static bool AudioReaderOpen(VideoReaderState* state, const std::filesystem::path& filepath);
+		// Only moves the reader, VideoReaderSeekFrame() also stops the decode thread and reopens a closed video
+		static bool VideoReaderSeekTo(VideoReaderState* state, int64_t ts);
+		// Seeks decode forward from the keyframe to the exact frame asked for, instead of stopping at the keyframe.
+		// Needs the video's seek index, without one seeks always land on keyframes.
+		static void SetAccurateSeek(bool accurate) { m_AccurateSeek = accurate; }
+		static bool IsAccurateSeekAvailable(const VideoReaderState* state) { return m_AccurateSeek && state->SeekIndex && !state->SeekIndex->IsEmpty(); }
+		// Exact pts of a frame number when the video has a seek index, an estimate otherwise
+		int64_t GetFramePts(int64_t frameIndex) const;
+		static bool AudioReaderOpen(VideoReaderState* state, const VideoSource& source);
+		// Sets up resampling and the PCM ring, AudioReaderReadFrame() does this before it starts the device
+		static bool AudioReaderInit(VideoReaderState* state);
 		bool AudioReaderReadFrame(VideoReaderState* state, bool isPaused);
+		static bool AudioReaderFillBuffer(VideoReaderState* state, int targetSamples);
+		static void AudioReaderClose(VideoReaderState* state);
 		bool AudioReaderSeekFrame(VideoReaderState* state, int64_t ts, bool resetAudio = false);
 		bool AVReaderSeekFrame(VideoReaderState* state, int64_t ts, bool resetAudio = false);
 		void PauseAudio(bool isPaused);
 		void CloseVideo(VideoReaderState* state);
 		void CloseAudio(VideoReaderState* state);
+		// Stops playback but keeps the demuxer, decoders, scaler and audio device open, rewound to the start
+		// with the first audio window already decoded, so playing again costs a seek instead of a reopen
+		bool StopAndRewind(VideoReaderState* state);
+
+		// Gapless looping, the start is demuxed and decoded while the end is still queued for presentation.
+		// Timestamps keep counting up across the loop point, GetLoopCount() passes of GetLoopDuration() seconds each.
+		void SetLooping(bool isLooping);
+		bool IsLooping() const { return m_IsLooping; }
+		uint32_t GetLoopCount() const;
+		double GetLoopDuration() const;
+
+		// Scrubbing shows frames from a cache that a background thread keeps filled around the playhead.
+		// Returns false if the frame isn't cached yet, the caller has to seek for it then.
+		static void SetFrameCacheBudget(size_t bytes) { m_FrameCacheBudget = bytes; }
+		bool PresentCachedFrame(int64_t frameIndex);
 
 		void ReadAndPlayAudio(VideoReaderState* state, int64_t ts, bool seek, bool isPaused);
+
+		// Only this much PCM is kept decoded ahead, the audio thread tops it up when it runs low
+		static void SetAudioBufferDuration(float seconds) { m_AudioBufferDuration = seconds; }
+		void StartAudioThread();
+		void StopAudioThread();
+
+		// Gain of this video in the shared audio mix
+		void SetVolume(float gain);
+		float GetVolume() const { return m_AudioGain; }
+		// Stream time of what is coming out of the speakers right now, counted from the PCM the device consumed.
+		// False while there's no audio playing to follow.
+		bool GetAudioClock(double& seconds) const;
+		// Frames the presentation scheduler skipped because they were late, and frames it had to show again
+		// because the next one wasn't decoded in time. Both growing means the decoder isn't keeping up.
+		uint64_t GetDroppedFrameCount() const { return m_Stats.DroppedFrames; }
+		uint64_t GetRepeatedFrameCount() const { return m_Stats.RepeatedFrames; }
+
+		// Per stage timings, queue depths and counters since the last reset, cheap enough to poll every frame
+		VideoStatsSnapshot GetStats();
+		void ResetStats() { m_Stats.Reset(); }
+
+		uint64_t GetAudioUnderrunCount() const { return m_VideoState.AudioBuffer ? m_VideoState.AudioBuffer->GetUnderrunCount() : 0; }
 		void ResetAudioPacketDuration(VideoReaderState* state);
 
-		static VideoReaderState GetVideoState();
+		VideoReaderState& GetVideoState() { return m_VideoState; }
+		VideoPlaybackState& GetPlaybackState() { return m_PlaybackState; }
+		bool IsAudioPaused() const { return m_PauseAudio; }
 
 		uint32_t GetWidth() const { return m_Width; }
 		uint32_t GetHeight() const { return m_Height; }
@@ -83,7 +208,8 @@ namespace Nutcrackz {
 		void SetRendererID(uint32_t id);
 
 		const std::string& GetVideoPath() const { return m_VideoPath; }
-		void SetVideoPath(const std::string& path) { m_VideoPath = path; }
+		void SetVideoPath(const std::string& path) { m_VideoPath = path; m_VideoSource = VideoSource(path); }
+		const VideoSource& GetVideoSource() const { return m_VideoSource; }
 
 		bool IsLoaded() const { return m_IsLoaded; }
 		void SetLinear(bool value) { m_Specification.UseLinear = value; }
@@ -99,26 +225,78 @@ namespace Nutcrackz {
 
 		static Ref<VideoTexture> Create(const TextureSpecification& specification);
 		static Ref<VideoTexture> Create(const std::string& path, uint8_t* frameData);
+		static Ref<VideoTexture> Create(const VideoSource& source, uint8_t* frameData);
 
 		static AssetType GetStaticType() { return AssetType::TextureVideo; }
 		virtual AssetType GetType() const { return GetStaticType(); }
 
 	private:
+		void SelectOutputFormat();
+		void CreateStreamingTexture(uint32_t width, uint32_t height, VideoFrameFormat format);
+		std::vector<VideoTexturePlane> GetFramePlanes() const;
+		void UploadFrame(const uint8_t* frameData);
+		bool OpenVideo();
+		void DecodeThread();
+		void StartScrubThread();
+		void StopScrubThread();
+		void ScrubThread();
+		bool FillFrameCache(int64_t firstFrame, int64_t lastFrame, int64_t windowStart, int64_t windowEnd);
+		static void ResetAudioBuffer(VideoReaderState* state);
+		static void SyncAudioToSeek(VideoReaderState* state);
+		void AudioThread();
+
+	private:
+		static const uint32_t MaxQueuedFrames = 4;
+		// The scrub reader is a second demuxer and decoder, it's closed once the playhead stood still this long
+		static const uint32_t ScrubIdleTimeoutMs = 5000;
+
 		TextureSpecification m_Specification;
 		std::string m_VideoPath;
+		VideoSource m_VideoSource;
 		uint32_t m_Width, m_Height;
 		uint32_t m_RendererID = 0;
+		uint32_t m_ChromaRendererIDs[2] = { 0, 0 };
+		VideoFrameFormat m_FrameFormat = VideoFrameFormat::RGBA;
 		uint32_t m_InternalFormat, m_DataFormat;
+		uint32_t m_MagFilter = 0;
 
 		bool m_IsLoaded = false;
 
-		inline static VideoReaderState m_VideoState;
-		inline static bool m_IsVideoLoaded = false;
-		inline static bool m_HasLoadedAudio = false;
+		VideoFrameQueue m_FrameQueue;
+		VideoPixelBufferRing m_UploadRing;
+		std::thread m_DecodeThread;
+		std::atomic<bool> m_IsDecoding = false;
+		VideoStats m_Stats;
+
+		VideoFrameCache m_FrameCache;
+		VideoReaderState m_ScrubState;
+		std::thread m_ScrubThread;
+		std::mutex m_ScrubMutex;
+		std::condition_variable m_ScrubCondition;
+		std::atomic<bool> m_IsScrubbing = false;
+		std::atomic<int64_t> m_ScrubTarget = -1;
+
+		std::thread m_AudioThread;
+		std::atomic<bool> m_IsDecodingAudio = false;
+
+		inline static VideoUploadMode m_PreferredUploadMode = VideoUploadMode::PersistentPixelBuffer;
+		inline static VideoFrameFormat m_PreferredFrameFormat = VideoFrameFormat::RGBA;
+		inline static float m_AudioBufferDuration = 0.5f;
+		inline static bool m_AccurateSeek = true;
+		inline static size_t m_FrameCacheBudget = 256 * 1024 * 1024;
+
+		VideoReaderState m_VideoState;
+		VideoPlaybackState m_PlaybackState;
+		bool m_IsVideoLoaded = false;
+		bool m_HasLoadedAudio = false;
 
-		inline static bool m_InitializedAudio = false;
-		inline static bool m_AudioStopped = false;
-		ma_device m_AudioDevice;
+		bool m_InitializedAudio = false;
+		bool m_AudioStopped = false;
+		std::atomic<bool> m_PauseAudio = false;
+		bool m_IsLooping = false;
+		uint32_t m_AudioSourceID = 0;
+		float m_AudioGain = 1.0f;
+		double m_AudioDeviceLatency = 0.0;
 	};
 
 }
\ No newline at end of file
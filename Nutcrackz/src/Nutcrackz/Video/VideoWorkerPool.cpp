@@ -0,0 +1,124 @@
+#include "nzpch.h"
+#include "VideoWorkerPool.h"
+
+#include "VideoDecodeScheduler.h"
+
+namespace Nutcrackz {
+
+	void VideoWorkerPool::Run(uint32_t count, uint32_t concurrency, const std::function<void(uint32_t)>& job)
+	{
+		if (count == 0)
+			return;
+
+		Batch batch;
+		batch.Job = &job;
+		batch.Count = count;
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if (!m_IsRunning)
+			Start();
+
+		// The calling thread works on the batch too, so it only needs concurrency - 1 helpers
+		batch.HelperSlots = std::min(std::max(1u, concurrency), (uint32_t)m_Workers.size() + 1) - 1;
+		if (batch.HelperSlots > 0 && count > 1)
+		{
+			m_Batches.push_back(&batch);
+			m_WorkAvailable.notify_all();
+		}
+
+		ExecuteJobs(batch, lock);
+
+		// Helpers may still be busy with the last jobs, the batch lives on our stack until they're done
+		m_WorkDone.wait(lock, [&]() { return batch.CompletedJobs == batch.Count; });
+	}
+
+	void VideoWorkerPool::Shutdown()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+
+			if (!m_IsRunning)
+				return;
+
+			m_IsRunning = false;
+		}
+
+		m_WorkAvailable.notify_all();
+
+		for (auto& worker : m_Workers)
+			worker.join();
+
+		m_Workers.clear();
+	}
+
+	uint32_t VideoWorkerPool::GetThreadCount()
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		if (!m_IsRunning)
+			Start();
+
+		return (uint32_t)m_Workers.size() + 1;
+	}
+
+	void VideoWorkerPool::Start()
+	{
+		// The thread asking for a conversion always works on it, so the pool is one thread short of the budget
+		const uint32_t workerCount = VideoDecodeScheduler::GetCoreBudget() - 1;
+
+		m_IsRunning = true;
+
+		for (uint32_t i = 0; i < workerCount; i++)
+			m_Workers.emplace_back(&VideoWorkerPool::WorkerThread);
+	}
+
+	void VideoWorkerPool::ExecuteJobs(Batch& batch, std::unique_lock<std::mutex>& lock)
+	{
+		while (batch.NextJob < batch.Count)
+		{
+			const uint32_t index = batch.NextJob++;
+
+			// Nothing left for anyone else to pick up
+			if (batch.NextJob == batch.Count)
+				RemoveBatch(&batch);
+
+			lock.unlock();
+			(*batch.Job)(index);
+			lock.lock();
+
+			// Notified under the lock, so the batch can't go out of scope before we let go of it
+			if (++batch.CompletedJobs == batch.Count)
+				m_WorkDone.notify_all();
+		}
+	}
+
+	void VideoWorkerPool::RemoveBatch(Batch* batch)
+	{
+		auto it = std::find(m_Batches.begin(), m_Batches.end(), batch);
+		if (it != m_Batches.end())
+			m_Batches.erase(it);
+	}
+
+	void VideoWorkerPool::WorkerThread()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		while (true)
+		{
+			m_WorkAvailable.wait(lock, []() { return !m_IsRunning || !m_Batches.empty(); });
+
+			if (!m_IsRunning)
+				return;
+
+			Batch* batch = m_Batches.front();
+
+			// Take the last free slot and the batch is out of reach for the other workers
+			if (--batch->HelperSlots == 0)
+				RemoveBatch(batch);
+
+			ExecuteJobs(*batch, lock);
+		}
+	}
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Nutcrackz {
+
+	// The threads every VideoConverter splits its conversions over. There is one pool for the whole process,
+	// sized from the VideoDecodeScheduler core budget when it is first used, so opening more videos only
+	// makes each conversion's share smaller instead of adding threads.
+	class VideoWorkerPool
+	{
+	public:
+		// Calls job(0) to job(count - 1) on at most `concurrency` threads, the calling thread included,
+		// and returns once all of them are done. Any number of threads may run jobs at the same time.
+		static void Run(uint32_t count, uint32_t concurrency, const std::function<void(uint32_t)>& job);
+		static void Shutdown();
+
+		// Workers plus the calling thread, starts the pool if it isn't yet
+		static uint32_t GetThreadCount();
+
+	private:
+		struct Batch
+		{
+			const std::function<void(uint32_t)>* Job = nullptr;
+			uint32_t Count = 0;
+			uint32_t NextJob = 0;
+			uint32_t CompletedJobs = 0;
+			// How many more workers may join in
+			uint32_t HelperSlots = 0;
+		};
+
+		static void Start();
+		static void ExecuteJobs(Batch& batch, std::unique_lock<std::mutex>& lock);
+		static void RemoveBatch(Batch* batch);
+		static void WorkerThread();
+
+	private:
+		inline static std::vector<std::thread> m_Workers;
+		inline static bool m_IsRunning = false;
+
+		// Batches that still have jobs nobody picked up and room for another worker
+		inline static std::vector<Batch*> m_Batches;
+
+		inline static std::mutex m_Mutex;
+		inline static std::condition_variable m_WorkAvailable;
+		inline static std::condition_variable m_WorkDone;
+	};
+
+}
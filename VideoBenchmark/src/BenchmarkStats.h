@@ -0,0 +1,59 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// Timings of one benchmark stage. Every sample is one call, items are frames (or opens, or seeks)
+// and bytes are whatever the stage produced, so MB/s means output throughput.
+class BenchmarkStats
+{
+public:
+	void Add(double seconds, uint64_t items = 1, uint64_t bytes = 0)
+	{
+		m_Samples.push_back(seconds);
+		m_TotalSeconds += seconds;
+		m_Items += items;
+		m_Bytes += bytes;
+	}
+
+	bool IsEmpty() const { return m_Samples.empty(); }
+	size_t GetCallCount() const { return m_Samples.size(); }
+
+	static void PrintHeader()
+	{
+		printf("  %-18s %8s %12s %10s %9s %9s %9s %9s\n", "stage", "calls", "items/s", "MB/s", "p50 ms", "p90 ms", "p99 ms", "max ms");
+	}
+
+	void Print(const char* stage) const
+	{
+		if (m_Samples.empty())
+		{
+			printf("  %-18s %8s\n", stage, "-");
+			return;
+		}
+
+		std::vector<double> sorted = m_Samples;
+		std::sort(sorted.begin(), sorted.end());
+
+		const double itemsPerSecond = m_TotalSeconds > 0.0 ? m_Items / m_TotalSeconds : 0.0;
+		const double megabytesPerSecond = m_TotalSeconds > 0.0 ? m_Bytes / m_TotalSeconds / (1024.0 * 1024.0) : 0.0;
+
+		printf("  %-18s %8zu %12.1f %10.1f %9.3f %9.3f %9.3f %9.3f\n", stage, sorted.size(), itemsPerSecond, megabytesPerSecond,
+			GetPercentile(sorted, 0.50) * 1000.0, GetPercentile(sorted, 0.90) * 1000.0, GetPercentile(sorted, 0.99) * 1000.0, sorted.back() * 1000.0);
+	}
+
+private:
+	// Nearest rank
+	static double GetPercentile(const std::vector<double>& sorted, double percentile)
+	{
+		const size_t rank = (size_t)(percentile * (sorted.size() - 1) + 0.5);
+		return sorted[std::min(rank, sorted.size() - 1)];
+	}
+
+private:
+	std::vector<double> m_Samples;
+	double m_TotalSeconds = 0.0;
+	uint64_t m_Items = 0;
+	uint64_t m_Bytes = 0;
+};
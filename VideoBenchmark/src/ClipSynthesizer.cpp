@@ -0,0 +1,249 @@
+#include "ClipSynthesizer.h"
+
+extern "C" {
+	#include <libavformat/avformat.h>
+	#include <libavutil/channel_layout.h>
+	#include <libavutil/opt.h>
+}
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace Utils {
+
+	static bool EncodeFrame(AVFormatContext* formatContext, AVCodecContext* codecContext, AVStream* stream, AVFrame* frame, AVPacket* packet)
+	{
+		int response = avcodec_send_frame(codecContext, frame);
+		if (response < 0)
+			return false;
+
+		while ((response = avcodec_receive_packet(codecContext, packet)) >= 0)
+		{
+			// The muxer picks the stream's time base when the header is written
+			av_packet_rescale_ts(packet, codecContext->time_base, stream->time_base);
+			packet->stream_index = stream->index;
+
+			if (av_interleaved_write_frame(formatContext, packet) < 0)
+				return false;
+		}
+
+		return response == AVERROR(EAGAIN) || response == AVERROR_EOF;
+	}
+
+	// Gradients that move every frame plus a bouncing block, so there is real motion to encode
+	static void FillVideoFrame(AVFrame* frame, int frameIndex)
+	{
+		const int width = frame->width;
+		const int height = frame->height;
+
+		for (int y = 0; y < height; y++)
+		{
+			uint8_t* row = frame->data[0] + (size_t)y * frame->linesize[0];
+			for (int x = 0; x < width; x++)
+				row[x] = (uint8_t)(x + y * 2 + frameIndex * 3);
+		}
+
+		const int blockSize = height / 4;
+		const int blockX = (frameIndex * 7) % std::max(1, width - blockSize);
+		const int blockY = (frameIndex * 5) % std::max(1, height - blockSize);
+
+		for (int y = blockY; y < blockY + blockSize; y++)
+			memset(frame->data[0] + (size_t)y * frame->linesize[0] + blockX, 235, blockSize);
+
+		for (int y = 0; y < (height + 1) / 2; y++)
+		{
+			uint8_t* u = frame->data[1] + (size_t)y * frame->linesize[1];
+			uint8_t* v = frame->data[2] + (size_t)y * frame->linesize[2];
+
+			for (int x = 0; x < (width + 1) / 2; x++)
+			{
+				u[x] = (uint8_t)(128 + y + frameIndex * 2);
+				v[x] = (uint8_t)(64 + x + frameIndex * 5);
+			}
+		}
+	}
+
+	static void FillAudioFrame(AVFrame* frame, int64_t firstSample)
+	{
+		const double frequency = 440.0;
+		const double pi = 3.14159265358979323846;
+
+		for (int channel = 0; channel < frame->ch_layout.nb_channels; channel++)
+		{
+			float* samples = (float*)frame->extended_data[channel];
+
+			for (int i = 0; i < frame->nb_samples; i++)
+				samples[i] = 0.25f * (float)std::sin(2.0 * pi * frequency * (double)(firstSample + i) / frame->sample_rate);
+		}
+	}
+
+	static AVCodecContext* OpenVideoEncoder(const ClipSpec& spec, const AVOutputFormat* outputFormat)
+	{
+		const AVCodec* codec = spec.EncoderName ? avcodec_find_encoder_by_name(spec.EncoderName) : nullptr;
+		if (!codec)
+			codec = avcodec_find_encoder(spec.VideoCodec);
+
+		if (!codec)
+		{
+			fprintf(stderr, "No encoder for %s, skipping it\n", avcodec_get_name(spec.VideoCodec));
+			return nullptr;
+		}
+
+		AVCodecContext* codecContext = avcodec_alloc_context3(codec);
+		if (!codecContext)
+			return nullptr;
+
+		codecContext->width = spec.Width;
+		codecContext->height = spec.Height;
+		codecContext->time_base = { 1, spec.Framerate };
+		codecContext->framerate = { spec.Framerate, 1 };
+		codecContext->gop_size = spec.KeyframeInterval;
+		codecContext->max_b_frames = spec.VideoCodec == AV_CODEC_ID_H264 ? 2 : 0;
+		codecContext->pix_fmt = spec.VideoCodec == AV_CODEC_ID_MJPEG ? AV_PIX_FMT_YUVJ420P : AV_PIX_FMT_YUV420P;
+		codecContext->bit_rate = (int64_t)spec.Width * spec.Height * spec.Framerate / 8;
+
+		if (outputFormat->flags & AVFMT_GLOBALHEADER)
+			codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+		// Encoding speed doesn't matter for what's being measured, these only exist on some of the encoders
+		av_opt_set(codecContext->priv_data, "preset", "veryfast", 0);
+		av_opt_set(codecContext->priv_data, "deadline", "realtime", 0);
+		av_opt_set(codecContext->priv_data, "cpu-used", "8", 0);
+
+		if (avcodec_open2(codecContext, codec, nullptr) < 0)
+		{
+			fprintf(stderr, "Could not open the %s encoder\n", codec->name);
+			avcodec_free_context(&codecContext);
+			return nullptr;
+		}
+
+		return codecContext;
+	}
+
+	static AVCodecContext* OpenAudioEncoder(const AVOutputFormat* outputFormat)
+	{
+		const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_AAC);
+		if (!codec)
+			return nullptr;
+
+		AVCodecContext* codecContext = avcodec_alloc_context3(codec);
+		if (!codecContext)
+			return nullptr;
+
+		codecContext->sample_fmt = AV_SAMPLE_FMT_FLTP;
+		codecContext->sample_rate = 48000;
+		codecContext->time_base = { 1, codecContext->sample_rate };
+		codecContext->bit_rate = 128000;
+		av_channel_layout_default(&codecContext->ch_layout, 2);
+
+		if (outputFormat->flags & AVFMT_GLOBALHEADER)
+			codecContext->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+		if (avcodec_open2(codecContext, codec, nullptr) < 0)
+		{
+			avcodec_free_context(&codecContext);
+			return nullptr;
+		}
+
+		return codecContext;
+	}
+
+}
+
+bool ClipSynthesizer::Write(const ClipSpec& spec, const std::filesystem::path& filepath)
+{
+	AVFormatContext* formatContext = nullptr;
+	if (avformat_alloc_output_context2(&formatContext, nullptr, "matroska", filepath.string().c_str()) < 0)
+		return false;
+
+	AVCodecContext* videoContext = Utils::OpenVideoEncoder(spec, formatContext->oformat);
+	AVCodecContext* audioContext = spec.HasAudio ? Utils::OpenAudioEncoder(formatContext->oformat) : nullptr;
+
+	AVStream* videoStream = videoContext ? avformat_new_stream(formatContext, nullptr) : nullptr;
+	AVStream* audioStream = audioContext ? avformat_new_stream(formatContext, nullptr) : nullptr;
+
+	AVFrame* videoFrame = av_frame_alloc();
+	AVFrame* audioFrame = av_frame_alloc();
+	AVPacket* packet = av_packet_alloc();
+
+	bool isSuccessful = videoStream && videoFrame && audioFrame && packet;
+
+	if (isSuccessful)
+	{
+		avcodec_parameters_from_context(videoStream->codecpar, videoContext);
+		videoStream->time_base = videoContext->time_base;
+
+		if (audioStream)
+		{
+			avcodec_parameters_from_context(audioStream->codecpar, audioContext);
+			audioStream->time_base = audioContext->time_base;
+		}
+
+		videoFrame->format = videoContext->pix_fmt;
+		videoFrame->width = spec.Width;
+		videoFrame->height = spec.Height;
+		isSuccessful = av_frame_get_buffer(videoFrame, 0) >= 0;
+
+		if (audioContext)
+		{
+			audioFrame->format = audioContext->sample_fmt;
+			audioFrame->sample_rate = audioContext->sample_rate;
+			audioFrame->nb_samples = audioContext->frame_size;
+			av_channel_layout_copy(&audioFrame->ch_layout, &audioContext->ch_layout);
+			isSuccessful = isSuccessful && av_frame_get_buffer(audioFrame, 0) >= 0;
+		}
+	}
+
+	isSuccessful = isSuccessful && avio_open(&formatContext->pb, filepath.string().c_str(), AVIO_FLAG_WRITE) >= 0;
+	isSuccessful = isSuccessful && avformat_write_header(formatContext, nullptr) >= 0;
+
+	const int frameCount = (int)(spec.Seconds * spec.Framerate);
+	int64_t audioSample = 0;
+
+	for (int i = 0; i < frameCount && isSuccessful; i++)
+	{
+		av_frame_make_writable(videoFrame);
+		Utils::FillVideoFrame(videoFrame, i);
+		videoFrame->pts = i;
+
+		isSuccessful = Utils::EncodeFrame(formatContext, videoContext, videoStream, videoFrame, packet);
+
+		// Keep the audio level with the video, so the muxer interleaves them the way real files are
+		while (audioContext && isSuccessful && audioSample * spec.Framerate <= (int64_t)(i + 1) * audioContext->sample_rate)
+		{
+			av_frame_make_writable(audioFrame);
+			Utils::FillAudioFrame(audioFrame, audioSample);
+			audioFrame->pts = audioSample;
+			audioSample += audioFrame->nb_samples;
+
+			isSuccessful = Utils::EncodeFrame(formatContext, audioContext, audioStream, audioFrame, packet);
+		}
+	}
+
+	// Drain both encoders
+	if (isSuccessful)
+		isSuccessful = Utils::EncodeFrame(formatContext, videoContext, videoStream, nullptr, packet);
+
+	if (isSuccessful && audioContext)
+		isSuccessful = Utils::EncodeFrame(formatContext, audioContext, audioStream, nullptr, packet);
+
+	if (isSuccessful)
+		isSuccessful = av_write_trailer(formatContext) >= 0;
+
+	if (formatContext->pb)
+		avio_closep(&formatContext->pb);
+
+	av_packet_free(&packet);
+	av_frame_free(&audioFrame);
+	av_frame_free(&videoFrame);
+	avcodec_free_context(&audioContext);
+	avcodec_free_context(&videoContext);
+	avformat_free_context(formatContext);
+
+	if (!isSuccessful)
+		std::filesystem::remove(filepath);
+
+	return isSuccessful;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+extern "C" {
+	#include <libavcodec/avcodec.h>
+}
+
+#include <filesystem>
+#include <string>
+
+// Describes a test clip, every clip gets an animated test pattern and a sine tone
+struct ClipSpec
+{
+	std::string Name;
+	AVCodecID VideoCodec = AV_CODEC_ID_NONE;
+	// Preferred encoder, any encoder for VideoCodec is used if it isn't built in
+	const char* EncoderName = nullptr;
+	int Width = 0, Height = 0;
+	int Framerate = 30;
+	float Seconds = 4.0f;
+	// Frames between keyframes, so that seeks have to decode forward
+	int KeyframeInterval = 60;
+	bool HasAudio = true;
+};
+
+// Encodes clips with libavcodec into Matroska files, so the benchmark needs no media of its own
+class ClipSynthesizer
+{
+public:
+	static bool Write(const ClipSpec& spec, const std::filesystem::path& filepath);
+};
@@ -0,0 +1,438 @@
+#include "Nutcrackz/Core/Log.h"
+#include "Nutcrackz/Video/VideoClock.h"
+#include "Nutcrackz/Video/VideoColorConversion.h"
+#include "Nutcrackz/Video/VideoProbeCache.h"
+#include "Nutcrackz/Video/VideoTexture.h"
+#include "Nutcrackz/Video/VideoWorkerPool.h"
+
+#include "BenchmarkStats.h"
+#include "ClipSynthesizer.h"
+
+extern "C" {
+	#include <libavutil/imgutils.h>
+}
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Nutcrackz;
+
+// Runs the reader stages of the video pipeline without a window, GL context or audio device:
+// opening, sequential decode, colour conversion, random seeks and audio decode.
+// 4:2:0 clips are also converted with the CPU reference of the video shader's YUV path and compared to swscale.
+// The mean "yuv reference vs swscale" difference is informational, not a correctness check: the two round differently.
+// The run only fails when the max difference goes over ColorDifference::MaxTolerance, or a clip doesn't decode.
+//
+//   VideoBenchmark [--seconds N] [--opens N] [--seeks N] [--keep] [clip ...]
+//
+// Without clips, test clips are encoded into the temp directory first.
+
+// How far the shader's YUV conversion (through its CPU reference) is from the RGBA path, per colour channel
+struct ColorDifference
+{
+	// Both sides replicate 4:2:0 chroma and use the clip's matrix and range, but round through their own
+	// fixed point tables, so a few steps apart is expected and anything beyond means a wrong matrix or range
+	static constexpr int MaxTolerance = 4;
+
+	uint64_t Total = 0;
+	uint64_t Count = 0;
+	int Max = 0;
+
+	void Add(const uint8_t* a, const uint8_t* b, size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount * 4; i++)
+		{
+			// The fourth byte is padding on the swscale side
+			if (i % 4 == 3)
+				continue;
+
+			const int difference = std::abs((int)a[i] - (int)b[i]);
+			Total += difference;
+			Max = std::max(Max, difference);
+			Count++;
+		}
+	}
+
+	void Print() const
+	{
+		if (Count == 0)
+			return;
+
+		printf("  yuv reference vs swscale: mean difference %.3f, max difference %d%s\n", (double)Total / Count, Max,
+			IsWithinTolerance() ? "" : " (FAILED)");
+	}
+
+	bool IsWithinTolerance() const { return Max <= MaxTolerance; }
+};
+
+struct BenchmarkOptions
+{
+	float Seconds = 4.0f;
+	int Opens = 10;
+	int Seeks = 50;
+	bool KeepClips = false;
+	std::vector<std::filesystem::path> Clips;
+};
+
+static Ref<VideoClock> s_Clock = VideoClock::CreateSteady();
+
+static double Now()
+{
+	return s_Clock->GetSeconds();
+}
+
+static bool ParseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const bool hasValue = i + 1 < argc;
+
+		if (!strcmp(argv[i], "--seconds") && hasValue)
+			options.Seconds = (float)atof(argv[++i]);
+		else if (!strcmp(argv[i], "--opens") && hasValue)
+			options.Opens = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--seeks") && hasValue)
+			options.Seeks = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "--keep"))
+			options.KeepClips = true;
+		else if (argv[i][0] == '-')
+			return false;
+		else
+			options.Clips.push_back(argv[i]);
+	}
+
+	return options.Seconds > 0.0f && options.Opens > 0 && options.Seeks >= 0;
+}
+
+static std::vector<ClipSpec> GetDefaultClips(float seconds)
+{
+	struct Codec { const char* Name; AVCodecID ID; const char* Encoder; };
+	struct Resolution { int Width, Height; };
+
+	const Codec codecs[] = { { "h264", AV_CODEC_ID_H264, "libx264" }, { "vp9", AV_CODEC_ID_VP9, "libvpx-vp9" }, { "mjpeg", AV_CODEC_ID_MJPEG, "mjpeg" } };
+	const Resolution resolutions[] = { { 640, 360 }, { 1280, 720 }, { 1920, 1080 } };
+
+	std::vector<ClipSpec> clips;
+
+	for (const auto& codec : codecs)
+	{
+		for (const auto& resolution : resolutions)
+		{
+			ClipSpec spec;
+			spec.Name = std::string(codec.Name) + "_" + std::to_string(resolution.Height) + "p";
+			spec.VideoCodec = codec.ID;
+			spec.EncoderName = codec.Encoder;
+			spec.Width = resolution.Width;
+			spec.Height = resolution.Height;
+			spec.Seconds = seconds;
+			clips.push_back(spec);
+		}
+	}
+
+	return clips;
+}
+
+static void BenchmarkOpen(const VideoSource& source, int opens, BenchmarkStats& coldStats, BenchmarkStats& warmStats)
+{
+	// Cold means neither a seek index nor probed stream info exist yet
+	std::filesystem::remove(VideoSeekIndex::GetSidecarPath(source));
+	VideoProbeCache::Clear();
+
+	for (int i = 0; i < opens; i++)
+	{
+		VideoReaderState state;
+
+		const double start = Now();
+		const bool isOpen = VideoTexture::VideoReaderOpen(&state, source);
+		const double elapsed = Now() - start;
+
+		// The index is built in the background and isn't part of the open, but the warm opens need its sidecar
+		if (state.SeekIndex)
+			state.SeekIndex->Wait();
+
+		VideoTexture::VideoReaderClose(&state);
+
+		if (!isOpen)
+			return;
+
+		(i == 0 ? coldStats : warmStats).Add(elapsed);
+	}
+}
+
+static void BenchmarkDecode(const VideoSource& source, BenchmarkStats& decodeStats, BenchmarkStats& convertStats,
+	BenchmarkStats& yuvStats, ColorDifference& yuvDifference)
+{
+	VideoReaderState state;
+	if (!VideoTexture::VideoReaderOpen(&state, source))
+	{
+		VideoTexture::VideoReaderClose(&state);
+		return;
+	}
+
+	const size_t pixelCount = (size_t)state.Width * state.Height;
+	uint8_t* frameBuffer = new uint8_t[pixelCount * 4];
+	uint8_t* yuvBuffer = new uint8_t[pixelCount * 4];
+
+	while (true)
+	{
+		int64_t pts;
+
+		double start = Now();
+		const bool isDecoded = VideoTexture::VideoReaderReadFrame(&state, nullptr, &pts, false);
+		double elapsed = Now() - start;
+
+		if (!isDecoded || state.EndOfStream)
+			break;
+
+		const int decodedSize = av_image_get_buffer_size((AVPixelFormat)state.VideoFrame->format, state.Width, state.Height, 1);
+		decodeStats.Add(elapsed, 1, decodedSize > 0 ? decodedSize : 0);
+
+		start = Now();
+		const bool isConverted = VideoTexture::VideoReaderConvertFrame(&state, frameBuffer);
+		elapsed = Now() - start;
+
+		if (!isConverted)
+			break;
+
+		convertStats.Add(elapsed, 1, (uint64_t)pixelCount * 4);
+
+		// Only frames the shader would get as Y, U and V planes
+		const AVFrame* frame = state.VideoFrame;
+		if (frame->format != AV_PIX_FMT_YUV420P && frame->format != AV_PIX_FMT_YUVJ420P)
+			continue;
+
+		start = Now();
+		ConvertYUV420ToRGBA(frame->data[0], frame->linesize[0], frame->data[1], frame->linesize[1], frame->data[2], frame->linesize[2],
+			state.Width, state.Height, yuvBuffer, state.Width * 4, state.ColorSpace, state.ColorRange);
+		elapsed = Now() - start;
+
+		yuvStats.Add(elapsed, 1, (uint64_t)pixelCount * 4);
+		yuvDifference.Add(yuvBuffer, frameBuffer, pixelCount);
+	}
+
+	delete[] yuvBuffer;
+	delete[] frameBuffer;
+	VideoTexture::VideoReaderClose(&state);
+}
+
+// Decodes to the end with the frames converted inside VideoReaderReadFrame(), the way the decode thread does it,
+// into Y, U and V planes like for the video shader. False if a frame failed before the end of the file.
+static bool BenchmarkPlanarDecode(const VideoSource& source, BenchmarkStats& planarStats)
+{
+	VideoReaderState state;
+	if (!VideoTexture::VideoReaderOpen(&state, source))
+	{
+		VideoTexture::VideoReaderClose(&state);
+		return false;
+	}
+
+	const AVPixelFormat pixelFormat = state.VideoCodecContext->pix_fmt;
+	if (pixelFormat != AV_PIX_FMT_YUV420P && pixelFormat != AV_PIX_FMT_YUVJ420P)
+	{
+		VideoTexture::VideoReaderClose(&state);
+		return true;
+	}
+
+	state.OutputFormat = VideoFrameFormat::YUV420;
+
+	const size_t lumaSize = (size_t)state.Width * state.Height;
+	const size_t frameSize = lumaSize + 2 * (size_t)((state.Width + 1) / 2) * ((state.Height + 1) / 2);
+	uint8_t* frameBuffer = new uint8_t[frameSize];
+
+	bool isSuccessful = true;
+
+	while (true)
+	{
+		int64_t pts;
+
+		const double start = Now();
+		const bool isRead = VideoTexture::VideoReaderReadFrame(&state, frameBuffer, &pts, false);
+		const double elapsed = Now() - start;
+
+		if (!isRead)
+		{
+			printf("  planar decode failed after %zu frames\n", planarStats.GetCallCount());
+			isSuccessful = false;
+			break;
+		}
+
+		if (state.EndOfStream)
+			break;
+
+		planarStats.Add(elapsed, 1, frameSize);
+	}
+
+	delete[] frameBuffer;
+	VideoTexture::VideoReaderClose(&state);
+	return isSuccessful;
+}
+
+static void BenchmarkSeek(const VideoSource& source, int seeks, BenchmarkStats& seekStats)
+{
+	VideoReaderState state;
+	if (!VideoTexture::VideoReaderOpen(&state, source))
+	{
+		VideoTexture::VideoReaderClose(&state);
+		return;
+	}
+
+	// Seeks are measured with the index, not with the fallback that is only used while it's being built
+	if (state.SeekIndex)
+	{
+		state.SeekIndex->Wait();
+
+		if (!state.SeekIndex->IsEmpty())
+			state.NumberOfFrames = state.SeekIndex->GetFrameCount();
+	}
+
+	if (state.NumberOfFrames <= 0)
+	{
+		VideoTexture::VideoReaderClose(&state);
+		return;
+	}
+
+	// Without a seek index, targets are estimated from the frame duration, which is only known once a frame was decoded
+	int64_t pts;
+	VideoTexture::VideoReaderReadFrame(&state, nullptr, &pts, false);
+
+	// Same targets on every run, so runs can be compared
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int64_t> frames(0, state.NumberOfFrames - 1);
+
+	for (int i = 0; i < seeks; i++)
+	{
+		const int64_t frameIndex = frames(random);
+		const bool hasIndex = state.SeekIndex && !state.SeekIndex->IsEmpty();
+		const int64_t ts = hasIndex ? state.SeekIndex->GetFramePts((uint32_t)frameIndex) : frameIndex * state.VideoPacketDuration;
+
+		// A seek is done once the frame at the target can be shown
+		const double start = Now();
+		const bool isSeeked = VideoTexture::VideoReaderSeekTo(&state, ts) && VideoTexture::VideoReaderReadFrame(&state, nullptr, &pts, false);
+		const double elapsed = Now() - start;
+
+		if (!isSeeked)
+			break;
+
+		seekStats.Add(elapsed);
+	}
+
+	VideoTexture::VideoReaderClose(&state);
+}
+
+static void BenchmarkAudio(const VideoSource& source, BenchmarkStats& audioStats)
+{
+	VideoReaderState state;
+	if (!VideoTexture::AudioReaderOpen(&state, source) || !VideoTexture::AudioReaderInit(&state))
+	{
+		VideoTexture::AudioReaderClose(&state);
+		return;
+	}
+
+	AudioRingBuffer& audioBuffer = *state.AudioBuffer;
+	const int windowSamples = (int)audioBuffer.GetCapacity() / 2;
+	uint8_t* output = new uint8_t[(size_t)audioBuffer.GetCapacity() * audioBuffer.GetBytesPerFrame()];
+
+	// Fills the window like the audio thread does, then drains it like the device callback would
+	while (!state.AudioEndOfStream)
+	{
+		const double start = Now();
+		const bool isFilled = VideoTexture::AudioReaderFillBuffer(&state, windowSamples);
+		const double elapsed = Now() - start;
+
+		if (!isFilled)
+			break;
+
+		const uint32_t frameCount = audioBuffer.Read(output, audioBuffer.GetAvailableRead());
+		audioStats.Add(elapsed, frameCount, (uint64_t)frameCount * audioBuffer.GetBytesPerFrame());
+	}
+
+	delete[] output;
+	VideoTexture::AudioReaderClose(&state);
+}
+
+static bool RunBenchmark(const std::filesystem::path& filepath, const BenchmarkOptions& options)
+{
+	const VideoSource source(filepath);
+
+	BenchmarkStats openCold, openWarm, decode, convert, convertYUV, planarDecode, seek, audio;
+	ColorDifference yuvDifference;
+
+	BenchmarkOpen(source, options.Opens, openCold, openWarm);
+
+	if (openCold.IsEmpty())
+	{
+		printf("%s: could not be opened\n\n", filepath.filename().string().c_str());
+		return false;
+	}
+
+	BenchmarkDecode(source, decode, convert, convertYUV, yuvDifference);
+	const bool isPlanarDecoded = BenchmarkPlanarDecode(source, planarDecode);
+	BenchmarkSeek(source, options.Seeks, seek);
+	BenchmarkAudio(source, audio);
+
+	printf("%s\n", filepath.filename().string().c_str());
+	BenchmarkStats::PrintHeader();
+	openCold.Print("open (cold)");
+	openWarm.Print("open (warm)");
+	decode.Print("decode");
+	convert.Print("convert (RGBA)");
+	convertYUV.Print("convert (YUV ref)");
+	planarDecode.Print("decode (YUV420)");
+	seek.Print("seek");
+	audio.Print("audio decode");
+	yuvDifference.Print();
+	printf("\n");
+
+	return isPlanarDecoded && yuvDifference.IsWithinTolerance();
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+
+	BenchmarkOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		printf("Usage: VideoBenchmark [--seconds N] [--opens N] [--seeks N] [--keep] [clip ...]\n");
+		return 1;
+	}
+
+	std::vector<std::filesystem::path> synthesizedClips;
+
+	if (options.Clips.empty())
+	{
+		const std::filesystem::path directory = std::filesystem::temp_directory_path() / "NutcrackzVideoBenchmark";
+		std::filesystem::create_directories(directory);
+
+		for (const ClipSpec& spec : GetDefaultClips(options.Seconds))
+		{
+			const std::filesystem::path filepath = directory / (spec.Name + ".mkv");
+			printf("Encoding %s...\n", filepath.filename().string().c_str());
+
+			if (ClipSynthesizer::Write(spec, filepath))
+				synthesizedClips.push_back(filepath);
+		}
+
+		options.Clips = synthesizedClips;
+		printf("\n");
+	}
+
+	bool isSuccessful = true;
+	for (const auto& filepath : options.Clips)
+		isSuccessful &= RunBenchmark(filepath, options);
+
+	if (!options.KeepClips)
+	{
+		for (const auto& filepath : synthesizedClips)
+		{
+			std::filesystem::remove(filepath);
+			std::filesystem::remove(VideoSeekIndex::GetSidecarPath(VideoSource(filepath)));
+		}
+	}
+
+	VideoWorkerPool::Shutdown();
+	return isSuccessful ? 0 : 1;
+}